@@ -0,0 +1,308 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "game.h"
+#include "tail_ring.h"
+#include "free_cells.h"
+#include "rng.h"
+
+#include <glm/glm.hpp>
+#include <stdlib.h>
+#include <string.h>
+
+// Many snakes on one board. Collisions go through a grid that records which snake owns each
+// cell, so a tick is a fixed number of passes over the live snakes and never compares snakes
+// pairwise:
+//
+//   1. every snake turns, picks its next cell and, unless growing, frees its tail cell
+//   2. every snake claims its next cell; a cell claimed twice this tick is contested
+//   3. snakes on a contested cell die head-to-head, snakes whose next cell is owned die
+//      head-to-body, the rest move in and eat whatever food is there
+//   4. dead snakes release their bodies and respawn a few ticks later
+//
+// As in the single-snake game, freeing tails first lets a head follow a tail. Snake 0 is the
+// player's; the rest can be steered with arena_steer_ai.
+
+#define ARENA_FREE 0u
+#define ARENA_FOOD 0xffffffffu
+#define ARENA_CONTESTED 0xffffffffu
+#define ARENA_INITIAL_LENGTH 3
+#define ARENA_RESPAWN_TICKS 10
+#define ARENA_SPAWN_ATTEMPTS 8
+// Defaults for sizing a board and its food to a snake count.
+#define ARENA_CELLS_PER_SNAKE 256
+#define ARENA_FOOD_PER_SNAKE 2
+
+struct ArenaSnake {
+    TailRing tail;
+    glm::ivec2 velocity;
+    TurnsQueue turns_queue;
+    glm::ivec2 next_pos;
+    u32 next_cell;
+    i32 grow;
+    bool32 alive;
+    i32 respawn_ticks;
+};
+
+struct Arena {
+    Board board;
+    u32 *owner;
+    // Ring slot of the body piece on each snake-owned cell, for drawing only what's in view.
+    u32 *slot;
+    u64 *claims;
+    FreeCellSet free_cells;
+    Rng rng;
+    ArenaSnake *snakes;
+    i32 snake_count;
+    i32 food_target;
+    i32 food_count;
+    u32 tick;
+    i64 deaths;
+    i64 food_eaten;
+};
+
+// Owner values 1..snake_count name snake index + 1.
+static u32 arena_owner_id(i32 snake) {
+    return (u32)snake + 1;
+}
+
+static void arena_take_cell(Arena *arena, u32 cell, u32 owner) {
+    arena->owner[cell] = owner;
+    free_cells_remove(&arena->free_cells, cell);
+}
+
+static void arena_release_cell(Arena *arena, u32 cell) {
+    arena->owner[cell] = ARENA_FREE;
+    free_cells_add(&arena->free_cells, cell);
+}
+
+static void arena_push_head(Arena *arena, i32 index, glm::ivec2 pos) {
+    ArenaSnake *snake = &arena->snakes[index];
+    if (snake->tail.size > snake->tail.mask) {
+        // Growing the ring moves every piece, so their slots are rewritten.
+        tail_reserve(&snake->tail, snake->tail.size + 1);
+        for (u32 i = 0; i < snake->tail.size; i++) {
+            arena->slot[board_index(&arena->board, tail_at(&snake->tail, i)->pos)] = i;
+        }
+    }
+
+    tail_push_front(&snake->tail, { pos });
+    u32 cell = board_index(&arena->board, pos);
+    arena_take_cell(arena, cell, arena_owner_id(index));
+    arena->slot[cell] = snake->tail.head;
+}
+
+static void arena_spawn_food(Arena *arena) {
+    while (arena->food_count < arena->food_target) {
+        i32 cell = free_cells_sample(&arena->free_cells, &arena->rng);
+        if (cell < 0) return;
+        arena_take_cell(arena, (u32)cell, ARENA_FOOD);
+        arena->food_count++;
+    }
+}
+
+// Places a fresh snake on a random free row of ARENA_INITIAL_LENGTH cells, heading right.
+// Returns false when no spot turned up; the snake tries again next tick.
+static bool32 arena_spawn_snake(Arena *arena, i32 index) {
+    ArenaSnake *snake = &arena->snakes[index];
+
+    for (i32 attempt = 0; attempt < ARENA_SPAWN_ATTEMPTS; attempt++) {
+        i32 sample = free_cells_sample(&arena->free_cells, &arena->rng);
+        if (sample < 0) return false;
+
+        // board_wrap only handles one step past an edge, so walk the row a cell at a time.
+        glm::ivec2 positions[ARENA_INITIAL_LENGTH];
+        positions[0] = board_position(&arena->board, (u32)sample);
+        bool32 is_free = true;
+        for (i32 i = 1; i < ARENA_INITIAL_LENGTH && is_free; i++) {
+            positions[i] = board_wrap(&arena->board, positions[i - 1] + glm::ivec2(1, 0));
+            is_free = arena->owner[board_index(&arena->board, positions[i])] == ARENA_FREE;
+        }
+        if (!is_free) continue;
+
+        tail_clear(&snake->tail);
+        for (i32 i = 0; i < ARENA_INITIAL_LENGTH; i++) {
+            arena_push_head(arena, index, positions[i]);
+        }
+
+        snake->velocity = { 1, 0 };
+        snake->turns_queue.size = 0;
+        snake->grow = 0;
+        snake->alive = true;
+        return true;
+    }
+
+    return false;
+}
+
+static void arena_kill_snake(Arena *arena, ArenaSnake *snake) {
+    for (u32 i = 0; i < snake->tail.size; i++) {
+        arena_release_cell(arena, board_index(&arena->board, tail_at(&snake->tail, i)->pos));
+    }
+    tail_clear(&snake->tail);
+    snake->alive = false;
+    snake->respawn_ticks = ARENA_RESPAWN_TICKS;
+    arena->deaths++;
+}
+
+void init_arena(Arena *arena, i32 width, i32 height, i32 snake_count, i32 food_target, u64 seed) {
+    arena->board = make_board(width, height);
+    arena->owner = (u32 *)calloc(arena->board.cell_count, sizeof(u32));
+    arena->slot = (u32 *)calloc(arena->board.cell_count, sizeof(u32));
+    arena->claims = (u64 *)calloc(arena->board.cell_count, sizeof(u64));
+    arena->free_cells = {};
+    init_free_cells(&arena->free_cells, arena->board.cell_count);
+    memset(arena->free_cells.slot, 0xff, arena->board.cell_count * sizeof(u32));
+    for (u32 cell = 0; cell < arena->board.cell_count; cell++) {
+        free_cells_add(&arena->free_cells, cell);
+    }
+
+    rng_seed(&arena->rng, seed);
+    arena->snake_count = snake_count < 1 ? 1 : snake_count;
+    arena->snakes = (ArenaSnake *)calloc(arena->snake_count, sizeof(ArenaSnake));
+    arena->food_target = food_target < 1 ? 1 : food_target;
+    arena->food_count = 0;
+    arena->tick = 0;
+    arena->deaths = 0;
+    arena->food_eaten = 0;
+
+    for (i32 i = 0; i < arena->snake_count; i++) {
+        ArenaSnake *snake = &arena->snakes[i];
+        init_tail(&snake->tail, 16);
+        if (!arena_spawn_snake(arena, i)) snake->respawn_ticks = 1;
+    }
+    arena_spawn_food(arena);
+}
+
+void free_arena(Arena *arena) {
+    for (i32 i = 0; i < arena->snake_count; i++) {
+        free_tail(&arena->snakes[i].tail);
+    }
+    free(arena->snakes);
+    free(arena->owner);
+    free(arena->slot);
+    free(arena->claims);
+    free_free_cells(&arena->free_cells);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void arena_tick(Arena *arena) {
+    const Board *board = &arena->board;
+    u64 stamp = (u64)++arena->tick << 32;
+
+    for (i32 i = 0; i < arena->snake_count; i++) {
+        ArenaSnake *snake = &arena->snakes[i];
+        if (!snake->alive) continue;
+
+        i32 direction = pop_queue(&snake->turns_queue);
+        if (direction && can_change_direction(snake->velocity, direction_to_velocity(direction))) {
+            snake->velocity = direction_to_velocity(direction);
+        }
+
+        snake->next_pos = board_wrap(board, tail_front(&snake->tail)->pos + snake->velocity);
+        snake->next_cell = board_index(board, snake->next_pos);
+
+        if (snake->grow > 0) {
+            snake->grow--;
+        } else {
+            arena_release_cell(arena, board_index(board, tail_back(&snake->tail)->pos));
+            tail_pop_back(&snake->tail);
+        }
+    }
+
+    for (i32 i = 0; i < arena->snake_count; i++) {
+        ArenaSnake *snake = &arena->snakes[i];
+        if (!snake->alive) continue;
+
+        u64 *claim = &arena->claims[snake->next_cell];
+        *claim = (*claim & ~0xffffffffull) == stamp ? stamp | ARENA_CONTESTED : stamp | arena_owner_id(i);
+    }
+
+    // Claims are unique past the contested check, so moving a head in never changes what a
+    // later snake sees in its own next cell.
+    for (i32 i = 0; i < arena->snake_count; i++) {
+        ArenaSnake *snake = &arena->snakes[i];
+        if (!snake->alive) continue;
+
+        u32 cell = snake->next_cell;
+        u32 owner = arena->owner[cell];
+        bool32 contested = (u32)arena->claims[cell] == ARENA_CONTESTED;
+        if (contested || (owner != ARENA_FREE && owner != ARENA_FOOD)) {
+            // Still occupying its old cells, so it is released after every head has moved.
+            snake->alive = false;
+            snake->respawn_ticks = -1;
+            continue;
+        }
+
+        if (owner == ARENA_FOOD) {
+            arena->food_count--;
+            arena->food_eaten++;
+            snake->grow++;
+            arena->owner[cell] = ARENA_FREE;
+        }
+
+        arena_push_head(arena, i, snake->next_pos);
+    }
+
+    for (i32 i = 0; i < arena->snake_count; i++) {
+        ArenaSnake *snake = &arena->snakes[i];
+        if (snake->alive) continue;
+
+        if (snake->respawn_ticks < 0) {
+            arena_kill_snake(arena, snake);
+        } else if (--snake->respawn_ticks <= 0 && !arena_spawn_snake(arena, i)) {
+            snake->respawn_ticks = 1;
+        }
+    }
+
+    arena_spawn_food(arena);
+}
+
+// Local policy for computer snakes: step onto adjacent food, otherwise keep going unless the
+// way ahead is blocked or a random turn comes up, preferring cells with more room around them.
+// Looks at a fixed neighbourhood, so it costs the same whatever the snake count.
+void arena_steer_ai(Arena *arena, i32 index) {
+    ArenaSnake *snake = &arena->snakes[index];
+    if (!snake->alive || snake->turns_queue.size > 0) return;
+
+    u32 head = board_index(&arena->board, tail_front(&snake->tail)->pos);
+    u32 neighbors[4];
+    board_neighbors(&arena->board, head, neighbors);
+
+    i32 current = velocity_to_direction(snake->velocity);
+    bool32 wander = rng_below(&arena->rng, 8) == 0;
+    i32 best_direction = DIRECTION_NONE;
+    i32 best_score = -1;
+
+    for (i32 direction = DIRECTION_UP; direction <= DIRECTION_LEFT; direction++) {
+        if (direction != current && !can_change_direction(snake->velocity, direction_to_velocity(direction))) continue;
+
+        u32 n = neighbors[direction - DIRECTION_UP];
+        u32 owner = arena->owner[n];
+        if (owner != ARENA_FREE && owner != ARENA_FOOD) continue;
+
+        u32 around[4];
+        board_neighbors(&arena->board, n, around);
+        i32 score = 0;
+        for (i32 i = 0; i < 4; i++) {
+            u32 around_owner = arena->owner[around[i]];
+            score += around_owner == ARENA_FREE || around_owner == ARENA_FOOD;
+        }
+
+        score *= 4;
+        if (owner == ARENA_FOOD) score += 32;
+        if (direction == current && !wander) score += 2;
+        score += (i32)rng_below(&arena->rng, 2);
+
+        if (score > best_score) {
+            best_score = score;
+            best_direction = direction;
+        }
+    }
+
+    if (best_direction && best_direction != current) push_queue(&snake->turns_queue, best_direction);
+}
+
+#endif
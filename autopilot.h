@@ -0,0 +1,309 @@
+#ifndef _AUTOPILOT_H_
+#define _AUTOPILOT_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "game.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Plans on a BFS distance field from every food cell through the free cells of the torus.
+// Between ticks only a few cells change (the old tail frees up, the new head blocks, food
+// moves), so the field is repaired around those cells instead of being rebuilt:
+//
+//   freed tail cell   its distance drops, so relax outwards from it
+//   blocked head cell cells whose every shortest path ran through it are collected level
+//                     by level, then refilled from their unaffected neighbours
+//
+// Both cost O(cells whose distance actually changes). Eating food moves the sources
+// themselves, which changes most of the field, so that tick rebuilds it.
+
+#define UNREACHABLE 0xffffffffu
+
+enum FieldFlags {
+    FIELD_BLOCKED = 1,
+    FIELD_FOOD = 2,
+    FIELD_AFFECTED = 4,
+    FIELD_QUEUED = 8,
+};
+
+struct Autopilot {
+    Board board;
+    u32 *dist;
+    u8 *flags;
+    u32 *queue;
+    u32 *affected;
+    u64 *seeds;
+    u32 head_cell;
+    u32 tail_cell;
+    i32 food_count;
+    u32 food_cells[MAX_FOOD];
+};
+
+void init_autopilot(Autopilot *pilot, const Board *board) {
+    pilot->board = *board;
+    pilot->dist = (u32 *)malloc(board->cell_count * sizeof(u32));
+    pilot->flags = (u8 *)malloc(board->cell_count * sizeof(u8));
+    pilot->queue = (u32 *)malloc(board->cell_count * sizeof(u32));
+    pilot->affected = (u32 *)malloc(board->cell_count * sizeof(u32));
+    pilot->seeds = (u64 *)malloc(board->cell_count * sizeof(u64));
+}
+
+void free_autopilot(Autopilot *pilot) {
+    free(pilot->dist);
+    free(pilot->flags);
+    free(pilot->queue);
+    free(pilot->affected);
+    free(pilot->seeds);
+    memset(pilot, 0, sizeof(*pilot));
+}
+
+// Breadth-first relaxation from the cells already in queue[0, count).
+static void field_relax(Autopilot *pilot, u32 count) {
+    u32 *dist = pilot->dist;
+    u32 neighbors[4];
+
+    for (u32 read = 0; read < count; read++) {
+        u32 cell = pilot->queue[read];
+        u32 next = dist[cell] + 1;
+        board_neighbors(&pilot->board, cell, neighbors);
+
+        for (i32 i = 0; i < 4; i++) {
+            u32 n = neighbors[i];
+            if ((pilot->flags[n] & FIELD_BLOCKED) || dist[n] <= next) continue;
+            dist[n] = next;
+            pilot->queue[count++] = n;
+        }
+    }
+}
+
+static u32 field_best_neighbor(Autopilot *pilot, u32 cell, u8 skip) {
+    u32 best = UNREACHABLE;
+    u32 neighbors[4];
+    board_neighbors(&pilot->board, cell, neighbors);
+
+    for (i32 i = 0; i < 4; i++) {
+        u32 n = neighbors[i];
+        if (!(pilot->flags[n] & skip) && pilot->dist[n] < best) best = pilot->dist[n];
+    }
+    return best;
+}
+
+static void field_lower(Autopilot *pilot, u32 cell, u32 distance) {
+    if (pilot->dist[cell] <= distance) return;
+    pilot->dist[cell] = distance;
+    pilot->queue[0] = cell;
+    field_relax(pilot, 1);
+}
+
+static i32 compare_seeds(const void *a, const void *b) {
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Recomputes every cell whose distance may have risen because `start` lost its support.
+// Candidates are decided in FIFO order, which is distance order, so by the time a cell is
+// checked every possible parent one level down has been decided already.
+static void field_raise(Autopilot *pilot, u32 start) {
+    u32 *dist = pilot->dist;
+    u8 *flags = pilot->flags;
+    u32 neighbors[4];
+    u32 count = 0, affected_count = 0;
+
+    pilot->queue[count++] = start;
+    flags[start] |= FIELD_QUEUED;
+
+    for (u32 read = 0; read < count; read++) {
+        u32 cell = pilot->queue[read];
+        if (dist[cell] == UNREACHABLE) continue;
+
+        bool32 supported = (flags[cell] & FIELD_FOOD) && !(flags[cell] & FIELD_BLOCKED);
+        if (!supported && !(flags[cell] & FIELD_BLOCKED) && dist[cell] > 0) {
+            supported = field_best_neighbor(pilot, cell, FIELD_BLOCKED | FIELD_AFFECTED) == dist[cell] - 1;
+        }
+        if (supported) continue;
+
+        flags[cell] |= FIELD_AFFECTED;
+        pilot->affected[affected_count++] = cell;
+
+        board_neighbors(&pilot->board, cell, neighbors);
+        for (i32 i = 0; i < 4; i++) {
+            u32 n = neighbors[i];
+            if ((flags[n] & (FIELD_BLOCKED | FIELD_QUEUED)) || dist[n] != dist[cell] + 1) continue;
+            flags[n] |= FIELD_QUEUED;
+            pilot->queue[count++] = n;
+        }
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        flags[pilot->queue[i]] &= ~FIELD_QUEUED;
+    }
+
+    // Refill from the unaffected boundary, smallest candidate distance first.
+    u32 seed_count = 0;
+    for (u32 i = 0; i < affected_count; i++) {
+        u32 cell = pilot->affected[i];
+        dist[cell] = UNREACHABLE;
+        if (flags[cell] & FIELD_BLOCKED) continue;
+
+        u32 best = (flags[cell] & FIELD_FOOD) ? 0 : field_best_neighbor(pilot, cell, FIELD_BLOCKED | FIELD_AFFECTED);
+        if (best == UNREACHABLE) continue;
+        u32 candidate = (flags[cell] & FIELD_FOOD) ? 0 : best + 1;
+        pilot->seeds[seed_count++] = ((u64)candidate << 32) | cell;
+    }
+
+    for (u32 i = 0; i < affected_count; i++) {
+        flags[pilot->affected[i]] &= ~FIELD_AFFECTED;
+    }
+
+    qsort(pilot->seeds, seed_count, sizeof(u64), compare_seeds);
+
+    // Two-queue BFS: seeds in sorted order merged with the FIFO of relaxed cells.
+    u32 next_seed = 0, read = 0;
+    count = 0;
+    while (next_seed < seed_count || read < count) {
+        u32 cell;
+        if (read < count && (next_seed == seed_count || dist[pilot->queue[read]] <= (u32)(pilot->seeds[next_seed] >> 32))) {
+            cell = pilot->queue[read++];
+        } else {
+            u64 seed = pilot->seeds[next_seed++];
+            cell = (u32)seed;
+            u32 candidate = (u32)(seed >> 32);
+            if (dist[cell] <= candidate) continue;
+            dist[cell] = candidate;
+        }
+
+        u32 next = dist[cell] + 1;
+        board_neighbors(&pilot->board, cell, neighbors);
+        for (i32 i = 0; i < 4; i++) {
+            u32 n = neighbors[i];
+            if ((flags[n] & FIELD_BLOCKED) || dist[n] <= next) continue;
+            dist[n] = next;
+            pilot->queue[count++] = n;
+        }
+    }
+}
+
+static void field_block(Autopilot *pilot, u32 cell) {
+    if (pilot->flags[cell] & FIELD_BLOCKED) return;
+    pilot->flags[cell] = (pilot->flags[cell] & ~FIELD_FOOD) | FIELD_BLOCKED;
+    field_raise(pilot, cell);
+}
+
+static void field_unblock(Autopilot *pilot, u32 cell) {
+    if (!(pilot->flags[cell] & FIELD_BLOCKED)) return;
+    pilot->flags[cell] &= ~FIELD_BLOCKED;
+
+    u32 best = field_best_neighbor(pilot, cell, FIELD_BLOCKED);
+    if (best != UNREACHABLE) field_lower(pilot, cell, best + 1);
+}
+
+static void remember_food(Autopilot *pilot, GameState *game) {
+    pilot->food_count = game->food_count;
+    for (i32 i = 0; i < game->food_count; i++) {
+        pilot->food_cells[i] = board_index(&game->board, game->food_pos[i]);
+    }
+}
+
+// Rebuilds the field from scratch; needed after restart_game or anything else that moves
+// more than one tick's worth of cells.
+void reset_autopilot(Autopilot *pilot, GameState *game) {
+    u32 count = 0;
+    for (u32 cell = 0; cell < pilot->board.cell_count; cell++) {
+        pilot->dist[cell] = UNREACHABLE;
+        pilot->flags[cell] = map_at(&game->map, cell) ? FIELD_BLOCKED : 0;
+    }
+
+    for (i32 i = 0; i < game->food_count; i++) {
+        u32 cell = board_index(&game->board, game->food_pos[i]);
+        pilot->flags[cell] |= FIELD_FOOD;
+        if (pilot->dist[cell] != 0 && !(pilot->flags[cell] & FIELD_BLOCKED)) {
+            pilot->dist[cell] = 0;
+            pilot->queue[count++] = cell;
+        }
+    }
+    field_relax(pilot, count);
+
+    pilot->head_cell = board_index(&game->board, tail_front(&game->snake.tail)->pos);
+    pilot->tail_cell = board_index(&game->board, tail_back(&game->snake.tail)->pos);
+    remember_food(pilot, game);
+}
+
+// Brings the field up to date after one update_snake call.
+void autopilot_tick(Autopilot *pilot, GameState *game, TickResult result) {
+    if (result == TICK_DIED) {
+        reset_autopilot(pilot, game);
+        return;
+    }
+
+    u32 head_cell = board_index(&game->board, tail_front(&game->snake.tail)->pos);
+    u32 tail_cell = board_index(&game->board, tail_back(&game->snake.tail)->pos);
+
+    // Every reachable cell's distance hangs off the food, so when food moves a rebuild is
+    // cheaper than repairing most of the board.
+    bool32 food_moved = game->food_count != pilot->food_count;
+    for (i32 i = 0; i < game->food_count && !food_moved; i++) {
+        food_moved = board_index(&game->board, game->food_pos[i]) != pilot->food_cells[i];
+    }
+    if (food_moved) {
+        reset_autopilot(pilot, game);
+        return;
+    }
+
+    if (!map_at(&game->map, pilot->tail_cell)) field_unblock(pilot, pilot->tail_cell);
+    field_block(pilot, head_cell);
+
+    pilot->head_cell = head_cell;
+    pilot->tail_cell = tail_cell;
+    remember_food(pilot, game);
+}
+
+// Picks the free neighbour closest to food, preferring to keep going straight on ties. When
+// no food is reachable it heads for the free neighbour with the most free cells around it.
+i32 autopilot_direction(Autopilot *pilot, GameState *game) {
+    u32 neighbors[4];
+    board_neighbors(&pilot->board, pilot->head_cell, neighbors);
+
+    i32 current = velocity_to_direction(game->snake.velocity);
+    i32 best_direction = DIRECTION_NONE;
+    u32 best_dist = UNREACHABLE;
+    i32 best_room = -1;
+
+    for (i32 direction = DIRECTION_UP; direction <= DIRECTION_LEFT; direction++) {
+        u32 n = neighbors[direction - DIRECTION_UP];
+        if (!can_change_direction(game->snake.velocity, direction_to_velocity(direction)) && direction != current) continue;
+        if (pilot->flags[n] & FIELD_BLOCKED) continue;
+
+        u32 dist = pilot->dist[n];
+        i32 room = 0;
+        if (dist == UNREACHABLE) {
+            u32 around[4];
+            board_neighbors(&pilot->board, n, around);
+            for (i32 i = 0; i < 4; i++) room += !(pilot->flags[around[i]] & FIELD_BLOCKED);
+        }
+
+        bool32 better = dist < best_dist || (dist == best_dist && (room > best_room || direction == current));
+        if (better) {
+            best_direction = direction;
+            best_dist = dist;
+            best_room = room;
+        }
+    }
+
+    return best_direction;
+}
+
+// Queues the planned turn unless a turn is already waiting. Returns the queued direction,
+// or DIRECTION_NONE when the snake keeps going straight.
+i32 autopilot_steer(Autopilot *pilot, GameState *game) {
+    if (game->turns_queue.size > 0) return DIRECTION_NONE;
+
+    i32 direction = autopilot_direction(pilot, game);
+    if (!direction || direction == velocity_to_direction(game->snake.velocity)) return DIRECTION_NONE;
+
+    push_queue(&game->turns_queue, direction);
+    return direction;
+}
+
+#endif
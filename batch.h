@@ -0,0 +1,357 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "game.h"
+#include "occupancy.h"
+#include "rng.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+    #include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+    #define BATCH_LANES 8
+#elif defined(__SSE4_1__)
+    #define BATCH_LANES 4
+#else
+    #define BATCH_LANES 1
+#endif
+
+// Many independent games stepped in lockstep, stored structure-of-arrays so the per-tick
+// core of update_snake (turn, wrap, collision lookup, food check) runs BATCH_LANES games at
+// a time. The rules match update_snake with a single food item. Bodies are rings of cell
+// indices and each game's occupancy is laid out as an OccupancyGrid; the kernels gather it as
+// u32 words, which on x86 hold the same bits.
+struct BatchGames {
+    Board board;
+    // `count` is rounded up to whole lanes; the games past `game_count` only pad the last one.
+    i32 count;
+    i32 game_count;
+
+    i32 *head_x;
+    i32 *head_y;
+    i32 *velocity_x;
+    i32 *velocity_y;
+    i32 *length;
+    i32 *should_grow;
+    i32 *food_cell;
+    Rng *rng;
+
+    u32 *body;
+    u32 *body_head;
+    u32 body_mask;
+
+    u64 *occupancy;
+    u32 occupancy_stride;
+
+    i32 *next_x;
+    i32 *next_y;
+    i32 *next_cell;
+    i32 *hit;
+    i32 *ate;
+};
+
+struct BatchStats {
+    i64 steps;
+    i64 food_eaten;
+    i64 deaths;
+    i64 wins;
+};
+
+static OccupancyGrid batch_map(BatchGames *batch, i32 game) {
+    return { batch->occupancy + (size_t)game * batch->occupancy_stride, batch->occupancy_stride,
+             batch->board.cell_count };
+}
+
+static const u32 *batch_occupancy_words(BatchGames *batch, i32 game) {
+    return (const u32 *)(batch->occupancy + (size_t)game * batch->occupancy_stride);
+}
+
+static void batch_set_cell(BatchGames *batch, i32 game, u32 cell, bool32 value) {
+    OccupancyGrid map = batch_map(batch, game);
+    map_set(&map, cell, value);
+}
+
+static void batch_spawn_food(BatchGames *batch, i32 game) {
+    u32 free_cells = batch->board.cell_count - batch->length[game];
+    if (free_cells == 0) {
+        batch->food_cell[game] = -1;
+        return;
+    }
+
+    OccupancyGrid map = batch_map(batch, game);
+    batch->food_cell[game] = map_nth_free(&map, rng_below(&batch->rng[game], free_cells));
+}
+
+static void batch_restart_game(BatchGames *batch, i32 game) {
+    const glm::ivec2 initial_positions[] = {
+        {3, 1}, {2, 1}, {1, 1}
+    };
+
+    OccupancyGrid map = batch_map(batch, game);
+    map_clear(&map);
+
+    u32 *body = batch->body + (size_t)game * (batch->body_mask + 1);
+    for (i32 i = 0; i < ARR_SIZE(initial_positions); i++) {
+        u32 cell = board_index(&batch->board, initial_positions[i]);
+        body[i] = cell;
+        batch_set_cell(batch, game, cell, true);
+    }
+
+    batch->body_head[game] = 0;
+    batch->length[game] = ARR_SIZE(initial_positions);
+    batch->head_x[game] = initial_positions[0].x;
+    batch->head_y[game] = initial_positions[0].y;
+    batch->velocity_x[game] = 1;
+    batch->velocity_y[game] = 0;
+    batch->should_grow[game] = false;
+    batch_spawn_food(batch, game);
+}
+
+// Game i draws from rng_split(seed, i), so every lane is reproducible on its own.
+void init_batch(BatchGames *batch, i32 count, i32 width, i32 height, u64 seed) {
+    batch->board = make_board(width, height);
+    batch->count = (count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    batch->game_count = count;
+    batch->body_mask = round_up_pow2(batch->board.cell_count) - 1;
+    batch->occupancy_stride = map_word_count(batch->board.cell_count);
+
+    size_t n = (size_t)batch->count;
+    i32 **lanes[] = {
+        &batch->head_x, &batch->head_y, &batch->velocity_x, &batch->velocity_y, &batch->length,
+        &batch->should_grow, &batch->food_cell, &batch->next_x, &batch->next_y, &batch->next_cell,
+        &batch->hit, &batch->ate,
+    };
+    for (i32 i = 0; i < ARR_SIZE(lanes); i++) {
+        *lanes[i] = (i32 *)malloc(n * sizeof(i32));
+    }
+
+    batch->rng = (Rng *)malloc(n * sizeof(Rng));
+    batch->body_head = (u32 *)malloc(n * sizeof(u32));
+    batch->body = (u32 *)malloc(n * (batch->body_mask + 1) * sizeof(u32));
+    batch->occupancy = (u64 *)malloc(n * batch->occupancy_stride * sizeof(u64));
+
+    for (i32 game = 0; game < batch->count; game++) {
+        batch->rng[game] = rng_split(seed, (u64)game);
+        batch_restart_game(batch, game);
+    }
+}
+
+void free_batch(BatchGames *batch) {
+    i32 *lanes[] = {
+        batch->head_x, batch->head_y, batch->velocity_x, batch->velocity_y, batch->length,
+        batch->should_grow, batch->food_cell, batch->next_x, batch->next_y, batch->next_cell,
+        batch->hit, batch->ate,
+    };
+    for (i32 i = 0; i < ARR_SIZE(lanes); i++) {
+        free(lanes[i]);
+    }
+
+    free(batch->rng);
+    free(batch->body_head);
+    free(batch->body);
+    free(batch->occupancy);
+    memset(batch, 0, sizeof(*batch));
+}
+
+// Direction -> velocity, indexed by Direction (DIRECTION_NONE maps to {0, 0}).
+static const i32 batch_turn_x[8] = { 0, 0, 1, 0, -1, 0, 0, 0 };
+static const i32 batch_turn_y[8] = { 0, -1, 0, 1, 0, 0, 0, 0 };
+
+static void batch_kernel_scalar(BatchGames *batch, i32 game, const i32 *directions) {
+    const Board *board = &batch->board;
+    i32 dir = directions && game < batch->game_count ? directions[game] : DIRECTION_NONE;
+    i32 turn_x = batch_turn_x[dir];
+    i32 turn_y = batch_turn_y[dir];
+
+    if ((batch->velocity_x[game] + turn_x) && (batch->velocity_y[game] + turn_y)) {
+        batch->velocity_x[game] = turn_x;
+        batch->velocity_y[game] = turn_y;
+    }
+
+    i32 x = batch->head_x[game] + batch->velocity_x[game];
+    i32 y = batch->head_y[game] + batch->velocity_y[game];
+    x = x < 0 ? board->width - 1 : (x >= board->width ? 0 : x);
+    y = y < 0 ? board->height - 1 : (y >= board->height ? 0 : y);
+    i32 cell = y * board->width + x;
+
+    batch->next_x[game] = x;
+    batch->next_y[game] = y;
+    batch->next_cell[game] = cell;
+    OccupancyGrid map = batch_map(batch, game);
+    batch->hit[game] = map_at(&map, (u32)cell);
+    batch->ate[game] = cell == batch->food_cell[game];
+}
+
+#if defined(__AVX2__)
+static void batch_kernel_avx2(BatchGames *batch, i32 first, const i32 *directions) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i width = _mm256_set1_epi32(batch->board.width);
+    const __m256i height = _mm256_set1_epi32(batch->board.height);
+    const __m256i turn_x_table = _mm256_loadu_si256((const __m256i *)batch_turn_x);
+    const __m256i turn_y_table = _mm256_loadu_si256((const __m256i *)batch_turn_y);
+
+    // The last group's padding lanes get no input; `directions` ends at game_count.
+    __m256i dir = zero;
+    if (directions) {
+        i32 valid = batch->game_count - first;
+        if (valid >= 8) {
+            dir = _mm256_loadu_si256((const __m256i *)(directions + first));
+        } else {
+            __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(valid), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            dir = _mm256_maskload_epi32(directions + first, mask);
+        }
+    }
+    __m256i vx = _mm256_loadu_si256((const __m256i *)(batch->velocity_x + first));
+    __m256i vy = _mm256_loadu_si256((const __m256i *)(batch->velocity_y + first));
+    __m256i turn_x = _mm256_permutevar8x32_epi32(turn_x_table, dir);
+    __m256i turn_y = _mm256_permutevar8x32_epi32(turn_y_table, dir);
+
+    // Same rule as can_change_direction: both components of old + new must be non-zero.
+    __m256i blocked = _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_add_epi32(vx, turn_x), zero),
+                                      _mm256_cmpeq_epi32(_mm256_add_epi32(vy, turn_y), zero));
+    vx = _mm256_blendv_epi8(turn_x, vx, blocked);
+    vy = _mm256_blendv_epi8(turn_y, vy, blocked);
+    _mm256_storeu_si256((__m256i *)(batch->velocity_x + first), vx);
+    _mm256_storeu_si256((__m256i *)(batch->velocity_y + first), vy);
+
+    __m256i x = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(batch->head_x + first)), vx);
+    __m256i y = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(batch->head_y + first)), vy);
+    x = _mm256_blendv_epi8(x, _mm256_sub_epi32(width, one), _mm256_cmpgt_epi32(zero, x));
+    y = _mm256_blendv_epi8(y, _mm256_sub_epi32(height, one), _mm256_cmpgt_epi32(zero, y));
+    x = _mm256_andnot_si256(_mm256_cmpeq_epi32(x, width), x);
+    y = _mm256_andnot_si256(_mm256_cmpeq_epi32(y, height), y);
+    __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(y, width), x);
+
+    __m256i lane_offset = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                             _mm256_set1_epi32((i32)batch->occupancy_stride * 2));
+    __m256i word_index = _mm256_add_epi32(lane_offset, _mm256_srli_epi32(cell, 5));
+    __m256i words = _mm256_i32gather_epi32((const int *)batch_occupancy_words(batch, first), word_index, 4);
+    __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(cell, _mm256_set1_epi32(31))), one);
+
+    __m256i food = _mm256_loadu_si256((const __m256i *)(batch->food_cell + first));
+    __m256i ate = _mm256_and_si256(_mm256_cmpeq_epi32(cell, food), one);
+
+    _mm256_storeu_si256((__m256i *)(batch->next_x + first), x);
+    _mm256_storeu_si256((__m256i *)(batch->next_y + first), y);
+    _mm256_storeu_si256((__m256i *)(batch->next_cell + first), cell);
+    _mm256_storeu_si256((__m256i *)(batch->hit + first), bit);
+    _mm256_storeu_si256((__m256i *)(batch->ate + first), ate);
+}
+#elif defined(__SSE4_1__)
+static void batch_kernel_sse(BatchGames *batch, i32 first, const i32 *directions) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i width = _mm_set1_epi32(batch->board.width);
+    const __m128i height = _mm_set1_epi32(batch->board.height);
+
+    i32 turn_x_lanes[4], turn_y_lanes[4];
+    for (i32 lane = 0; lane < 4; lane++) {
+        i32 dir = directions && first + lane < batch->game_count ? directions[first + lane] : DIRECTION_NONE;
+        turn_x_lanes[lane] = batch_turn_x[dir];
+        turn_y_lanes[lane] = batch_turn_y[dir];
+    }
+
+    __m128i turn_x = _mm_loadu_si128((const __m128i *)turn_x_lanes);
+    __m128i turn_y = _mm_loadu_si128((const __m128i *)turn_y_lanes);
+    __m128i vx = _mm_loadu_si128((const __m128i *)(batch->velocity_x + first));
+    __m128i vy = _mm_loadu_si128((const __m128i *)(batch->velocity_y + first));
+
+    __m128i blocked = _mm_or_si128(_mm_cmpeq_epi32(_mm_add_epi32(vx, turn_x), zero),
+                                   _mm_cmpeq_epi32(_mm_add_epi32(vy, turn_y), zero));
+    vx = _mm_blendv_epi8(turn_x, vx, blocked);
+    vy = _mm_blendv_epi8(turn_y, vy, blocked);
+    _mm_storeu_si128((__m128i *)(batch->velocity_x + first), vx);
+    _mm_storeu_si128((__m128i *)(batch->velocity_y + first), vy);
+
+    __m128i x = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(batch->head_x + first)), vx);
+    __m128i y = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(batch->head_y + first)), vy);
+    x = _mm_blendv_epi8(x, _mm_sub_epi32(width, one), _mm_cmplt_epi32(x, zero));
+    y = _mm_blendv_epi8(y, _mm_sub_epi32(height, one), _mm_cmplt_epi32(y, zero));
+    x = _mm_andnot_si128(_mm_cmpeq_epi32(x, width), x);
+    y = _mm_andnot_si128(_mm_cmpeq_epi32(y, height), y);
+    __m128i cell = _mm_add_epi32(_mm_mullo_epi32(y, width), x);
+
+    // No gather or per-lane variable shift before AVX2, so the bit lookups are done per lane.
+    i32 cells[4];
+    _mm_storeu_si128((__m128i *)cells, cell);
+    __m128i bit = _mm_setr_epi32((i32)(batch_occupancy_words(batch, first + 0)[cells[0] >> 5] >> (cells[0] & 31)) & 1,
+                                 (i32)(batch_occupancy_words(batch, first + 1)[cells[1] >> 5] >> (cells[1] & 31)) & 1,
+                                 (i32)(batch_occupancy_words(batch, first + 2)[cells[2] >> 5] >> (cells[2] & 31)) & 1,
+                                 (i32)(batch_occupancy_words(batch, first + 3)[cells[3] >> 5] >> (cells[3] & 31)) & 1);
+
+    __m128i food = _mm_loadu_si128((const __m128i *)(batch->food_cell + first));
+    __m128i ate = _mm_and_si128(_mm_cmpeq_epi32(cell, food), one);
+
+    _mm_storeu_si128((__m128i *)(batch->next_x + first), x);
+    _mm_storeu_si128((__m128i *)(batch->next_y + first), y);
+    _mm_storeu_si128((__m128i *)(batch->next_cell + first), cell);
+    _mm_storeu_si128((__m128i *)(batch->hit + first), bit);
+    _mm_storeu_si128((__m128i *)(batch->ate + first), ate);
+}
+#endif
+
+// Advances every game by one tick. `directions` holds one Direction for each of the
+// game_count games (or is NULL for no input); padding lanes get none. Dead and finished games restart in place, like update_snake. Only the
+// first game_count games count towards `stats`.
+void step_batch(BatchGames *batch, const i32 *directions, BatchStats *stats) {
+    u32 body_capacity = batch->body_mask + 1;
+
+    for (i32 game = 0; game < batch->count; game++) {
+        if (batch->should_grow[game]) {
+            batch->should_grow[game] = false;
+        } else {
+            u32 *body = batch->body + (size_t)game * body_capacity;
+            u32 tail_slot = (batch->body_head[game] + batch->length[game] - 1) & batch->body_mask;
+            batch_set_cell(batch, game, body[tail_slot], false);
+            batch->length[game]--;
+        }
+    }
+
+    for (i32 first = 0; first < batch->count; first += BATCH_LANES) {
+#if defined(__AVX2__)
+        batch_kernel_avx2(batch, first, directions);
+#elif defined(__SSE4_1__)
+        batch_kernel_sse(batch, first, directions);
+#else
+        batch_kernel_scalar(batch, first, directions);
+#endif
+    }
+
+    for (i32 game = 0; game < batch->count; game++) {
+        bool32 is_counted = game < batch->game_count;
+        if (batch->hit[game]) {
+            stats->deaths += is_counted;
+            batch_restart_game(batch, game);
+            continue;
+        }
+
+        u32 *body = batch->body + (size_t)game * body_capacity;
+        u32 cell = (u32)batch->next_cell[game];
+        batch->body_head[game] = (batch->body_head[game] - 1) & batch->body_mask;
+        body[batch->body_head[game]] = cell;
+        batch_set_cell(batch, game, cell, true);
+        batch->head_x[game] = batch->next_x[game];
+        batch->head_y[game] = batch->next_y[game];
+        batch->length[game]++;
+
+        if ((u32)batch->length[game] == batch->board.cell_count) {
+            stats->wins += is_counted;
+            batch_restart_game(batch, game);
+        } else if (batch->ate[game]) {
+            stats->food_eaten += is_counted;
+            batch->should_grow[game] = true;
+            batch_spawn_food(batch, game);
+        }
+    }
+
+    stats->steps += batch->game_count;
+}
+
+#endif
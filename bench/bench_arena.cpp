@@ -0,0 +1,51 @@
+#include "../typedefs.h"
+#include "../arena.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+// Multi-snake tick cost as the snake count grows at a fixed density of cells per snake. With
+// collisions resolved through the owner grid, ns per snake-tick should stay flat. The AI
+// steering is timed separately from arena_tick.
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void bench_arena(i32 snake_count, i32 ticks) {
+    i32 side = (i32)ceil(sqrt((double)snake_count * ARENA_CELLS_PER_SNAKE));
+    Arena arena = {};
+    init_arena(&arena, side, side, snake_count, snake_count * ARENA_FOOD_PER_SNAKE, 1);
+
+    double steer_time = 0.0, tick_time = 0.0;
+    i64 snake_ticks = 0;
+    for (i32 tick = 0; tick < ticks; tick++) {
+        double start = now_seconds();
+        for (i32 i = 0; i < arena.snake_count; i++) {
+            arena_steer_ai(&arena, i);
+        }
+        double steered = now_seconds();
+        arena_tick(&arena);
+        tick_time += now_seconds() - steered;
+        steer_time += steered - start;
+        snake_ticks += snake_count;
+    }
+
+    printf("%7d %5dx%-5d %10.1f %10.1f %10.2f %10lld %10lld\n", snake_count, side, side, tick_time * 1e9 / snake_ticks,
+           steer_time * 1e9 / snake_ticks, ticks / (tick_time + steer_time), (long long)arena.food_eaten,
+           (long long)arena.deaths);
+
+    free_arena(&arena);
+}
+
+i32 main() {
+    printf("%7s %-11s %10s %10s %10s %10s %10s\n", "snakes", "board", "tick ns", "steer ns", "ticks/s", "food", "deaths");
+
+    const i32 counts[] = { 10, 100, 1000, 10000 };
+    for (i32 i = 0; i < ARR_SIZE(counts); i++) {
+        bench_arena(counts[i], 20000000 / counts[i] < 2000 ? 2000 : 20000000 / counts[i]);
+    }
+
+    return 0;
+}
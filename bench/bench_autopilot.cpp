@@ -0,0 +1,76 @@
+#include "../typedefs.h"
+#include "../game.h"
+#include "../autopilot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+
+// Planning latency per tick: the incremental field repair plus the turn choice, against
+// rebuilding the distance field from scratch every tick. The snake is driven by the
+// autopilot itself, so the changed cells are the ones a real game produces.
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void bench_autopilot(i32 board, i32 ticks) {
+    GameState game = {};
+    init_game(&game, board, board);
+    seed_game(&game, 1);
+    restart_game(&game);
+
+    Autopilot pilot = {};
+    init_autopilot(&pilot, &game.board);
+    reset_autopilot(&pilot, &game);
+
+    std::vector<double> samples(ticks);
+    double total = 0.0;
+    i64 food_eaten = 0, deaths = 0;
+
+    for (i32 tick = 0; tick < ticks; tick++) {
+        double start = now_seconds();
+        autopilot_steer(&pilot, &game);
+        double planned = now_seconds() - start;
+
+        TickResult result = update_snake(&game);
+        if (result == TICK_ATE) food_eaten++;
+        if (result == TICK_DIED) deaths++;
+
+        start = now_seconds();
+        autopilot_tick(&pilot, &game, result);
+        double elapsed = planned + now_seconds() - start;
+
+        total += elapsed;
+        samples[tick] = elapsed;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double p99 = samples[(size_t)(ticks * 0.99)];
+    double worst = samples.back();
+
+    i32 rebuilds = ticks / 100 + 1;
+    double start = now_seconds();
+    for (i32 i = 0; i < rebuilds; i++) {
+        reset_autopilot(&pilot, &game);
+    }
+    double rebuild = (now_seconds() - start) / rebuilds;
+
+    printf("%5dx%-5d %8lld %7lld %10.2f %10.2f %10.2f %12.2f\n", board, board, (long long)food_eaten, (long long)deaths,
+           total * 1e6 / ticks, p99 * 1e6, worst * 1e6, rebuild * 1e6);
+
+    free_autopilot(&pilot);
+    free_game(&game);
+}
+
+i32 main() {
+    printf("%-11s %8s %7s %10s %10s %10s %12s\n", "board", "food", "deaths", "avg us", "p99 us", "worst us", "rebuild us");
+
+    const i32 boards[] = { 16, 32, 64, 128, 256, 512, 1024 };
+    for (i32 i = 0; i < ARR_SIZE(boards); i++) {
+        bench_autopilot(boards[i], 20000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include "../typedefs.h"
+#include "../board.h"
+#include "../game.h"
+#include "../batch.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Single-thread steps/sec for the SoA batch stepper against calling update_snake on each
+// game in turn. Both sides see the same input policy: every game turns in a random
+// direction roughly one tick in eight. Before timing anything it checks map_nth_free, which
+// places the batch's food, against a cell-by-cell count, and steps a batch and one GameState
+// per game side by side; it exits non-zero if either disagrees.
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static u32 next_random(u32 *state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void fill_directions(i32 *directions, i32 count, u32 *state) {
+    for (i32 i = 0; i < count; i++) {
+        u32 r = next_random(state);
+        directions[i] = (r & 7) == 0 ? DIRECTION_UP + (i32)((r >> 3) & 3) : DIRECTION_NONE;
+    }
+}
+
+// Returns the lookups where map_nth_free disagrees with counting free cells one at a time.
+static u32 check_nth_free(u32 cell_count, u32 *state) {
+    OccupancyGrid map;
+    init_map(&map, cell_count);
+    u32 mismatches = 0;
+
+    // From an empty map to a full one, so every word is seen both sparse and dense.
+    const u32 densities[] = { 0, 1, 4, 7, 8 };
+    for (i32 d = 0; d < ARR_SIZE(densities); d++) {
+        map_clear(&map);
+        for (u32 cell = 0; cell < cell_count; cell++) {
+            if ((next_random(state) & 7) < densities[d]) map_set(&map, cell, 1);
+        }
+
+        u32 n = 0;
+        for (u32 cell = 0; cell < cell_count; cell++) {
+            if (map_at(&map, cell)) continue;
+            mismatches += map_nth_free(&map, n) != (i32)cell;
+            n++;
+        }
+        mismatches += map_nth_free(&map, n) != -1;
+    }
+
+    free_map(&map);
+    return mismatches;
+}
+
+// Differences between game `lane` of the batch and `game`: head, velocity, body, occupancy,
+// food and growth.
+static u32 compare_lane(BatchGames *batch, i32 lane, GameState *game) {
+    TailRing *tail = &game->snake.tail;
+    u32 errors = 0;
+    errors += glm::ivec2(batch->head_x[lane], batch->head_y[lane]) != tail_front(tail)->pos;
+    errors += glm::ivec2(batch->velocity_x[lane], batch->velocity_y[lane]) != game->snake.velocity;
+    errors += batch->should_grow[lane] != (i32)game->snake.should_grow;
+    if ((u32)batch->length[lane] != tail->size) return errors + 1;
+
+    const u32 *body = batch->body + (size_t)lane * (batch->body_mask + 1);
+    for (u32 i = 0; i < tail->size; i++) {
+        errors += body[(batch->body_head[lane] + i) & batch->body_mask] != board_index(&game->board, tail_at(tail, i)->pos);
+    }
+
+    OccupancyGrid map = batch_map(batch, lane);
+    errors += memcmp(map.words, game->map.words, map.word_count * sizeof(u64)) != 0;
+    errors += game->food_count != (batch->food_cell[lane] >= 0);
+    return errors;
+}
+
+// Steps `games` lanes and a GameState per lane with the same seeds and inputs, comparing them
+// after every tick. The batch picks the n-th free cell in row-major order for food where
+// update_snake picks from the free-cell set's own order, so both draw the same n but may land
+// on different cells; the game's food is moved to the lane's before the next tick. Returns the
+// differences found.
+static u32 check_batch(i32 board, i32 games, i32 ticks, u64 seed) {
+    // Exactly one per game, as step_batch documents, so a read into the padding lanes overruns it.
+    i32 *directions = (i32 *)malloc(games * sizeof(i32));
+    BatchGames batch = {};
+    init_batch(&batch, games, board, board, seed);
+    GameState *states = new GameState[games]();
+    for (i32 i = 0; i < games; i++) {
+        init_game(&states[i], board, board);
+        states[i].rng = rng_split(seed, (u64)i);
+        restart_game(&states[i]);
+    }
+
+    u32 errors = 0;
+    u32 state = 99;
+    BatchStats stats = {};
+    i64 deaths = 0, food_eaten = 0;
+    for (i32 tick = 0; tick < ticks; tick++) {
+        for (i32 i = 0; i < games; i++) {
+            GameState *game = &states[i];
+            i32 cell = batch.food_cell[i];
+            if (game->food_count == 1 && cell >= 0 && game->food_pos[0] != board_position(&game->board, (u32)cell)) {
+                free_cells_add(&game->free_cells, board_index(&game->board, game->food_pos[0]));
+                free_cells_remove(&game->free_cells, (u32)cell);
+                game->food_pos[0] = board_position(&game->board, (u32)cell);
+            }
+        }
+
+        fill_directions(directions, games, &state);
+        step_batch(&batch, directions, &stats);
+        for (i32 i = 0; i < games; i++) {
+            if (directions[i]) push_queue(&states[i].turns_queue, directions[i]);
+            TickResult result = update_snake(&states[i]);
+            deaths += result == TICK_DIED;
+            food_eaten += result == TICK_ATE;
+            errors += compare_lane(&batch, i, &states[i]);
+        }
+    }
+
+    errors += stats.steps != (i64)games * ticks;
+    errors += stats.deaths != deaths;
+    errors += stats.food_eaten != food_eaten;
+
+    for (i32 i = 0; i < games; i++) {
+        free_game(&states[i]);
+    }
+    delete[] states;
+    free_batch(&batch);
+    free(directions);
+    return errors;
+}
+
+static double bench_update_snake(i32 board, i32 games, i32 ticks, i32 *directions, i64 *deaths) {
+    GameState *states = new GameState[games]();
+    for (i32 i = 0; i < games; i++) {
+        init_game(&states[i], board, board);
+        states[i].rng = rng_split(1, (u64)i);
+        restart_game(&states[i]);
+    }
+
+    u32 state = 12345;
+    double elapsed = 0;
+    for (i32 tick = 0; tick < ticks; tick++) {
+        fill_directions(directions, games, &state);
+
+        double start = now_seconds();
+        for (i32 i = 0; i < games; i++) {
+            if (directions[i]) push_queue(&states[i].turns_queue, directions[i]);
+            if (update_snake(&states[i]) == TICK_DIED) (*deaths)++;
+        }
+        elapsed += now_seconds() - start;
+    }
+
+    for (i32 i = 0; i < games; i++) {
+        free_game(&states[i]);
+    }
+    delete[] states;
+
+    return (double)games * ticks / elapsed;
+}
+
+static double bench_batch(i32 board, i32 games, i32 ticks, i32 *directions, BatchStats *stats) {
+    BatchGames batch = {};
+    init_batch(&batch, games, board, board, 1);
+
+    u32 state = 12345;
+    double elapsed = 0;
+    for (i32 tick = 0; tick < ticks; tick++) {
+        fill_directions(directions, games, &state);
+
+        double start = now_seconds();
+        step_batch(&batch, directions, stats);
+        elapsed += now_seconds() - start;
+    }
+
+    free_batch(&batch);
+    return (double)stats->steps / elapsed;
+}
+
+i32 main() {
+    const i32 boards[] = { 15, 64, 256 };
+    const i32 games = 4096;
+    const i32 ticks = 2000;
+    i32 *directions = (i32 *)malloc(games * sizeof(i32));
+
+    const u32 cell_counts[] = { 1, 63, 64, 225, 256, 257, 4096, 65536 + 17 };
+    u32 state = 777, mismatches = 0;
+    for (i32 i = 0; i < ARR_SIZE(cell_counts); i++) {
+        mismatches += check_nth_free(cell_counts[i], &state);
+    }
+    printf("map_nth_free: %u mismatches against a cell-by-cell count\n", mismatches);
+
+    // Game counts that don't fill the last group of lanes, so the padding is in play.
+    u32 differences = check_batch(8, 37, 3000, 5) + check_batch(15, 100, 3000, 6) +
+                      check_batch(37, BATCH_LANES * 3 + 1, 3000, 7);
+    printf("step_batch: %u differences from update_snake\n", differences);
+    if (mismatches || differences) return 1;
+
+    printf("batch lanes: %d, %d games x %d ticks\n", BATCH_LANES, games, ticks);
+    printf("%6s | %18s %18s %8s\n", "board", "update_snake st/s", "batch st/s", "speedup");
+
+    for (i32 i = 0; i < ARR_SIZE(boards); i++) {
+        i64 deaths = 0;
+        BatchStats stats = {};
+        double per_game = bench_update_snake(boards[i], games, ticks, directions, &deaths);
+        double batched = bench_batch(boards[i], games, ticks, directions, &stats);
+
+        printf("%6d | %18.0f %18.0f %7.2fx   (deaths %lld / %lld, food %lld)\n", boards[i],
+               per_game, batched, batched / per_game, (long long)deaths, (long long)stats.deaths,
+               (long long)stats.food_eaten);
+    }
+
+    free(directions);
+    return 0;
+}
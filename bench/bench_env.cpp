@@ -0,0 +1,58 @@
+#include "../snake_env.cpp"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Env steps per second through the C interface with random actions written into the shared
+// buffer, the way a trainer drives it. One thread; trainers shard env sets across cores.
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void bench_env(i32 count, i32 board, i32 food_count, i64 total_steps) {
+    u64 size = snake_env_buffer_size(count, board, board, food_count);
+    void *buffer = aligned_alloc(ENV_ALIGNMENT, align_offset(size));
+    SnakeEnv *env = snake_env_create(count, board, board, food_count, 1, buffer, size);
+    SnakeEnvHeader *header = snake_env_header(env);
+
+    i32 *actions = (i32 *)((u8 *)buffer + header->actions_offset);
+    const float *rewards = (const float *)((u8 *)buffer + header->rewards_offset);
+    const u8 *dones = (const u8 *)buffer + header->dones_offset;
+    Rng rng = rng_split(2, 0);
+
+    i64 steps = total_steps / count;
+    i64 food_eaten = 0, episodes = 0;
+    double start = now_seconds();
+    for (i64 step = 0; step < steps; step++) {
+        for (i32 i = 0; i < count; i++) {
+            actions[i] = (i32)rng_below(&rng, 5);
+        }
+        snake_env_step(env);
+        for (i32 i = 0; i < count; i++) {
+            food_eaten += rewards[i] > 0.0f;
+            episodes += dones[i];
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("%7d %5dx%-5d %5d %12.2f %12lld %10lld %10.2f\n", count, board, board, food_count,
+           steps * count / elapsed / 1e6, (long long)food_eaten, (long long)episodes, (double)size / 1024.0);
+
+    snake_env_destroy(env);
+    free(buffer);
+}
+
+i32 main() {
+    printf("%7s %-11s %5s %12s %12s %10s %10s\n", "envs", "board", "food", "Msteps/s", "food", "episodes", "buffer KiB");
+
+    const i32 counts[] = { 1, 64, 1024, 16384 };
+    for (i32 i = 0; i < ARR_SIZE(counts); i++) {
+        bench_env(counts[i], 15, 1, 20000000);
+    }
+    bench_env(1024, 15, 4, 20000000);
+    bench_env(1024, 64, 1, 20000000);
+
+    return 0;
+}
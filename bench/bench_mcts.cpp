@@ -0,0 +1,117 @@
+#include "../typedefs.h"
+#include "../platform.h"
+#include "../game.h"
+#include "../frame_pacer.h"
+#include "../mcts.h"
+
+#include <stdio.h>
+#include <thread>
+
+// Rollouts/sec of the MCTS player for 1, 2, 4, ... threads up to the core count, searching
+// from the same mid-game position each time. Then the MCTS pilot as the render loop drives it:
+// the time each frame spends ticking, searching in the background against blocking for half a
+// tick as it used to. Exits non-zero if a frame with the background search overruns the
+// display interval.
+
+#define PILOT_FRAME_RATE 60
+#define PILOT_TICK_RATE 10
+#define PILOT_SECONDS 3
+// TICK_CLOCK_MAX_CATCH_UP in framerate.h: the most ticks one frame runs after a stall.
+#define PILOT_CATCH_UP 8
+
+static void bench_mcts(i32 board, i32 thread_count, double budget, i32 searches) {
+    GameState game = {};
+    init_game(&game, board, board);
+    seed_game(&game, 1);
+    restart_game(&game);
+
+    MctsPool *pool = new MctsPool();
+    init_mcts(pool, &game.board, thread_count, 1);
+
+    i64 total = 0;
+    for (i32 i = 0; i < searches; i++) {
+        i64 rollouts;
+        mcts_search(pool, &game, budget, &rollouts);
+        total += rollouts;
+    }
+
+    double per_second = total / (budget * searches);
+    printf("%4dx%-4d %8d %14.0f %14.0f\n", board, board, thread_count, per_second, per_second / thread_count);
+
+    free_mcts(pool);
+    delete pool;
+    free_game(&game);
+}
+
+// Returns the longest a frame spent ticking. One tick every PILOT_FRAME_RATE / PILOT_TICK_RATE
+// frames, and once a second PILOT_CATCH_UP of them back to back.
+static u64 pilot_frames(i32 board, i32 thread_count, bool32 is_blocking, i64 *deaths) {
+    GameState game = {};
+    init_game(&game, board, board);
+    seed_game(&game, 1);
+    restart_game(&game);
+    MctsPool *pool = new MctsPool();
+    init_mcts(pool, &game.board, thread_count, 1);
+
+    FramePacer pacer;
+    init_frame_pacer(&pacer, PILOT_FRAME_RATE, FRAME_PACER_DEFAULT_SPIN_NS);
+    u64 max_frame_ns = 0;
+    for (i32 frame = 0; frame < PILOT_FRAME_RATE * PILOT_SECONDS; frame++) {
+        i32 ticks = frame % (PILOT_FRAME_RATE / PILOT_TICK_RATE) == 0 ? 1 : 0;
+        if (frame % PILOT_FRAME_RATE == PILOT_FRAME_RATE / 2) ticks = PILOT_CATCH_UP;
+
+        u64 start = platform_time_ns();
+        for (i32 tick = 0; tick < ticks; tick++) {
+            if (is_blocking) {
+                i32 direction = mcts_search(pool, &game, 0.5 / PILOT_TICK_RATE, NULL);
+                if (direction && !game.turns_queue.size) push_queue(&game.turns_queue, direction);
+            } else {
+                mcts_steer(pool, &game);
+            }
+            *deaths += update_snake(&game) == TICK_DIED;
+            if (!is_blocking) mcts_begin(pool, &game, mcts_tick_budget(PILOT_TICK_RATE));
+        }
+        u64 frame_ns = platform_time_ns() - start;
+        if (frame_ns > max_frame_ns) max_frame_ns = frame_ns;
+        wait_for_next_frame(&pacer);
+    }
+
+    free_mcts(pool);
+    delete pool;
+    free_game(&game);
+    return max_frame_ns;
+}
+
+i32 main() {
+    i32 cores = (i32)std::thread::hardware_concurrency();
+    if (cores < 1) cores = 1;
+
+    printf("%-9s %8s %14s %14s\n", "board", "threads", "rollouts/sec", "per thread");
+    const i32 boards[] = { 15, 64 };
+    for (i32 b = 0; b < ARR_SIZE(boards); b++) {
+        for (i32 threads = 1; threads <= cores; threads *= 2) {
+            bench_mcts(boards[b], threads, 0.05, 20);
+        }
+        if ((cores & (cores - 1)) != 0) bench_mcts(boards[b], cores, 0.05, 20);
+    }
+
+    // As main.cpp runs it, leaving a core to the render loop.
+    i32 threads = cores > 1 ? cores - 1 : 1;
+    u64 interval_ns = 1000000000ull / PILOT_FRAME_RATE;
+    printf("\npilot at %d ticks/s, %d frames/s (%.2f ms), %d threads\n", PILOT_TICK_RATE, PILOT_FRAME_RATE,
+           interval_ns / 1e6, threads);
+    printf("%-9s %-10s %14s %8s\n", "board", "search", "max frame ms", "deaths");
+    bool32 is_smooth = true;
+    for (i32 b = 0; b < ARR_SIZE(boards); b++) {
+        for (i32 is_blocking = 1; is_blocking >= 0; is_blocking--) {
+            i64 deaths = 0;
+            u64 max_frame_ns = pilot_frames(boards[b], threads, is_blocking, &deaths);
+            printf("%4dx%-4d %-10s %14.3f %8lld\n", boards[b], boards[b], is_blocking ? "blocking" : "background",
+                   max_frame_ns / 1e6, (long long)deaths);
+            if (!is_blocking && max_frame_ns >= interval_ns) is_smooth = false;
+        }
+    }
+    printf("background search %s the frame interval\n", is_smooth ? "stays within" : "overruns");
+
+    return is_smooth ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include "../typedefs.h"
+#include "../platform.h"
+#include "../frame_pacer.h"
+
+#include <stdio.h>
+
+// Frame pacing jitter at common refresh rates: the previous millisecond pacer (u32 ms
+// timestamps, 1000 / fps integer period, relative usleep) against FramePacer with and without
+// the spin tail. Each frame busy-works for a fixed time, standing in for update and render.
+// Jitter is how far a frame's start-to-start time lands from the target period.
+
+#define BENCH_SECONDS 2
+#define BENCH_WORK_NS 1000000ull
+
+static void busy_work() {
+    u64 end = platform_time_ns() + BENCH_WORK_NS;
+    while (platform_time_ns() < end) {}
+}
+
+struct LegacyPacer {
+    u32 fps;
+    u32 prev_time;
+    u32 current_time;
+    i32 time_slept;
+};
+
+static void legacy_wait(LegacyPacer *fr) {
+    fr->current_time = (u32)(platform_time_ns() / 1000000);
+    u32 time_taken = fr->current_time - fr->prev_time - fr->time_slept;
+    fr->prev_time = fr->current_time;
+
+    fr->time_slept = 1000 / fr->fps - time_taken;
+    if (fr->time_slept < 0) {
+        fr->time_slept = 0;
+    }
+
+    platform_sleep(fr->time_slept);
+}
+
+static void report(const char *name, u32 frame_rate, FramePacer *stats, u64 elapsed_ns) {
+    double expected = (double)elapsed_ns / stats->period_ns;
+    printf("%-10s %5u %10.3f %10.3f %10.3f %10.3f %10.2f\n", name, frame_rate,
+           elapsed_ns / 1e6 / stats->frames, frame_time_percentile(stats, 0.5) / 1e6,
+           frame_jitter_percentile(stats, 0.5) / 1e6, frame_jitter_percentile(stats, 0.99) / 1e6,
+           100.0 * ((double)stats->frames - expected) / expected);
+}
+
+static void bench_legacy(u32 frame_rate) {
+    // Only for the histogram and the period; the legacy pacer does the waiting.
+    FramePacer stats;
+    init_frame_pacer(&stats, frame_rate, 0);
+    LegacyPacer legacy = {};
+    legacy.fps = frame_rate;
+    legacy_wait(&legacy);
+
+    u64 start = platform_time_ns(), last = start;
+    while (last - start < BENCH_SECONDS * 1000000000ull) {
+        busy_work();
+        legacy_wait(&legacy);
+        u64 now = platform_time_ns();
+        record_frame_time(&stats, now - last);
+        last = now;
+    }
+    report("legacy", frame_rate, &stats, last - start);
+}
+
+static void bench_pacer(const char *name, u32 frame_rate, u64 spin_ns) {
+    FramePacer pacer;
+    init_frame_pacer(&pacer, frame_rate, spin_ns);
+
+    u64 start = pacer.start_ns;
+    while (pacer.last_frame_ns - start < BENCH_SECONDS * 1000000000ull) {
+        busy_work();
+        wait_for_next_frame(&pacer);
+    }
+    report(name, frame_rate, &pacer, pacer.last_frame_ns - start);
+    printf("%16s overshoot mean %.3f ms, max %.3f ms, drift %.3f ms, resyncs %llu\n", "",
+           pacer.overshoot_ns / 1e6 / pacer.frames, pacer.max_overshoot_ns / 1e6, pacer.drift_ns / 1e6,
+           (unsigned long long)pacer.resyncs);
+}
+
+i32 main() {
+    printf("%-10s %5s %10s %10s %10s %10s %10s\n", "pacer", "fps", "mean ms", "p50 ms", "p50 jit", "p99 jit",
+           "rate err %");
+
+    const u32 rates[] = { 60, 144, 240 };
+    for (i32 i = 0; i < ARR_SIZE(rates); i++) {
+        bench_legacy(rates[i]);
+        bench_pacer("sleep", rates[i], 0);
+        bench_pacer("sleep+spin", rates[i], FRAME_PACER_DEFAULT_SPIN_NS);
+    }
+
+    return 0;
+}
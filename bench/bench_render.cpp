@@ -0,0 +1,378 @@
+#define GAP 12.0f
+
+#include "../typedefs.h"
+#include "../platform.h"
+#include "../game.h"
+#include "../snake.h"
+#include "../grid.h"
+#include "../board_pass.h"
+#include "../gl_calls.h"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+
+// Frame cost of drawing the game into an offscreen 1080x1080 target, without a window: an
+// EGL surfaceless context (Mesa's llvmpipe when there's no GPU) and a renderbuffer. Each frame
+// builds the instance batch, submits it and waits with glFinish; submit time and GL calls are
+// counted up to that glFinish. Each scene runs with the stream buffer persistently mapped and
+// with it orphaned. The body is drawn from its GPU mirror or by walking the view, as in the
+// game, or by the board pass (board_pass.h) in place of the instances and the grid; cells and
+// bridges count instances sent per frame. B/tick is what keeping the mirror, or the board
+// texture, current uploaded over a few ticks afterwards. The check that follows draws the same
+// frames both ways and counts the pixels where the board pass differs from the instanced
+// renderer; -c DIR also writes each pair as PPM files. Run from the repository root, as the
+// shaders are loaded from ./shaders.
+
+#define BENCH_WINDOW_SIDE 1080
+#define BENCH_WARMUP_FRAMES 10
+
+static bool32 create_headless_context() {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!get_platform_display) return false;
+
+    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (!eglInitialize(display, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API)) return false;
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return false;
+
+    return gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+}
+
+#define BENCH_UPLOAD_TICKS 20
+
+// One tick along a boustrophedon path (right on odd rows, left on even ones).
+static void step_snake(GameState *game, bool32 should_grow) {
+    glm::ivec2 head = tail_front(&game->snake.tail)->pos;
+    bool32 going_right = head.y & 1;
+    i32 direction = going_right ? DIRECTION_RIGHT : DIRECTION_LEFT;
+    if ((going_right && head.x == game->board.width - 1) || (!going_right && head.x == 0)) {
+        direction = DIRECTION_DOWN;
+    }
+
+    push_queue(&game->turns_queue, direction);
+    game->snake.should_grow = should_grow;
+    if (update_snake(game) == TICK_DIED) restart_game(game);
+}
+
+static void grow_snake(GameState *game, u32 length) {
+    while (game->snake.tail.size < length) step_snake(game, true);
+}
+
+// What a frame draws with, as set up in main.cpp.
+struct BenchRenderer {
+    ObjectData cell;
+    ObjectData bridge;
+    ObjectData grid;
+    ObjectData body_cell;
+    ObjectData body_bridge;
+    FrameData frame_data;
+    StreamBuffer stream;
+    BodyMirror body_mirror;
+    BodyIndex body_index;
+    InstanceBatch batch;
+    BoardPass board_pass;
+    bool32 has_board_pass;
+};
+
+static void init_bench_renderer(BenchRenderer *renderer, GameState *game, bool32 allow_persistent) {
+    glm::ivec2 window_size = { BENCH_WINDOW_SIDE, BENCH_WINDOW_SIDE };
+    renderer->cell = configure_cell();
+    renderer->bridge = configure_bridge();
+    renderer->frame_data = make_frame_data(glm::vec2(CAMERA_CELL_SIZE, CAMERA_CELL_SIZE), GAP);
+    init_stream_buffer(&renderer->stream, (GLADloadproc)eglGetProcAddress, allow_persistent);
+    renderer->grid = configure_grid(window_size, game->board);
+    renderer->body_cell = configure_body_cell();
+    renderer->body_bridge = configure_body_bridge();
+    init_body_mirror(&renderer->body_mirror);
+    renderer->body_index = {};
+    init_body_index(&renderer->body_index, game->board.cell_count);
+    init_instance_batch(&renderer->batch);
+    renderer->has_board_pass = init_board_pass(&renderer->board_pass, &game->board);
+}
+
+static void free_bench_renderer(BenchRenderer *renderer) {
+    if (renderer->has_board_pass) free_board_pass(&renderer->board_pass);
+    free_body_mirror(&renderer->body_mirror);
+    free_stream_buffer(&renderer->stream);
+    free_instance_batch(&renderer->batch);
+    free_body_index(&renderer->body_index);
+}
+
+enum BenchBody {
+    BENCH_BODY_FITTED,
+    BENCH_BODY_VIEW,
+    BENCH_BODY_BOARD,
+};
+
+// Draws one frame like main.cpp's loop: the body from the mirror or the view as it fits, or
+// with BENCH_BODY_VIEW always from the view, or everything with the board pass. Returns
+// whether the mirror drew the body.
+static bool32 draw_frame(BenchRenderer *renderer, GameState *game, CameraView *view, i32 body,
+                         const SnakeMotion *motion, float alpha) {
+    const glm::vec3 color = glm::vec3(1.0f, 0.0f, 0.0f);
+    StreamBuffer *stream = &renderer->stream;
+    InstanceBatch *batch = &renderer->batch;
+    bool32 draws_body_mirror = false;
+
+    glClear(GL_COLOR_BUFFER_BIT);
+    clear_instance_batch(batch);
+    if (body == BENCH_BODY_BOARD) {
+        sync_board_pass(&renderer->board_pass, game);
+    } else {
+        for (i32 i = 0; i < game->food_count; i++) {
+            push_visible_food(batch, &game->board, view, game->food_pos[i]);
+        }
+        draws_body_mirror = body == BENCH_BODY_FITTED && body_fits_view(&game->snake.tail, view);
+        if (!draws_body_mirror) {
+            push_snake(batch, &game->board, &game->map, &game->snake.tail, &renderer->body_index, view, color, motion,
+                       alpha);
+        }
+    }
+
+    u64 body_bytes = draws_body_mirror ? stream_space(stream, sizeof(BodyData)) : 0;
+    if (body == BENCH_BODY_BOARD) body_bytes = stream_space(stream, sizeof(BoardData));
+    if (body != BENCH_BODY_BOARD) {
+        body_bytes += body_mirror_stream_bytes(&renderer->body_mirror, &game->snake.tail, stream);
+    }
+    begin_stream_frame(stream, stream_space(stream, sizeof(FrameData)) + instance_batch_bytes(batch, stream) + body_bytes);
+    if (body != BENCH_BODY_BOARD) sync_body_mirror(&renderer->body_mirror, &game->snake.tail, stream);
+    apply_camera_view(view, &renderer->frame_data, stream);
+    if (body == BENCH_BODY_BOARD) {
+        render_board_pass(&renderer->board_pass, stream, game, view, color, motion, alpha);
+    } else {
+        render_instance_batch(batch, stream, &renderer->cell, &renderer->bridge);
+    }
+    if (draws_body_mirror) {
+        render_snake_body(&renderer->body_cell, &renderer->body_bridge, &renderer->body_mirror, stream, &game->board,
+                          &game->snake.tail, view, color, motion, alpha);
+    }
+    end_stream_frame(stream);
+    if (body != BENCH_BODY_BOARD && view->is_whole_board) render_object(&renderer->grid);
+    return draws_body_mirror;
+}
+
+static void bench_render(i32 side, u32 length, i32 frames, bool32 allow_persistent, bool32 uses_board_pass) {
+    GameState game = {};
+    init_game(&game, side, side);
+    seed_game(&game, 1);
+    restart_game(&game);
+    grow_snake(&game, length);
+
+    glm::ivec2 window_size = { BENCH_WINDOW_SIDE, BENCH_WINDOW_SIDE };
+    BenchRenderer renderer = {};
+    init_bench_renderer(&renderer, &game, allow_persistent);
+    if (uses_board_pass && !renderer.has_board_pass) {
+        printf("%5dx%-5d board too large for a texture\n", side, side);
+        free_bench_renderer(&renderer);
+        free_game(&game);
+        return;
+    }
+    Camera camera = make_camera(&game.board);
+    StreamBuffer *stream = &renderer.stream;
+
+    u64 start = 0, submit = 0, calls = 0, stalls = 0;
+    bool32 draws_body_mirror = false;
+    for (i32 frame = -BENCH_WARMUP_FRAMES; frame < frames; frame++) {
+        if (frame == 0) start = platform_time_ns(), submit = calls = 0, stalls = stream->stalls;
+        u64 frame_start = platform_time_ns();
+        u64 frame_calls = gl_call_count;
+
+        camera_follow(&camera, glm::vec2(tail_front(&game.snake.tail)->pos));
+        CameraView view = camera_view(&camera, &game.board, window_size);
+        draws_body_mirror = draw_frame(&renderer, &game, &view, uses_board_pass ? BENCH_BODY_BOARD : BENCH_BODY_FITTED,
+                                       NULL, 0.0f);
+        calls += gl_call_count - frame_calls;
+        submit += platform_time_ns() - frame_start;
+        glFinish();
+    }
+
+    u64 elapsed = platform_time_ns() - start;
+
+    // What keeping the body mirror, or the board texture, current costs per tick, at this length.
+    u64 uploaded = 0;
+    for (i32 tick = 0; tick < BENCH_UPLOAD_TICKS; tick++) {
+        step_snake(&game, false);
+        if (uses_board_pass) {
+            uploaded += sync_board_pass(&renderer.board_pass, &game);
+        } else {
+            begin_stream_frame(stream, body_mirror_stream_bytes(&renderer.body_mirror, &game.snake.tail, stream));
+            uploaded += sync_body_mirror(&renderer.body_mirror, &game.snake.tail, stream);
+            end_stream_frame(stream);
+        }
+    }
+
+    const char *body = uses_board_pass ? "board" : (draws_body_mirror ? "mirror" : "view");
+    printf("%5dx%-5d %8u %-6s %8u %8u %-10s %10.3f %10.3f %11.1f %7llu %7.0f\n", side, side, game.snake.tail.size, body,
+           renderer.batch.cell_count, renderer.batch.bridge_count,
+           is_stream_buffer_persistent(stream) ? "mapped" : "orphaned", elapsed / 1e6 / frames, submit / 1e6 / frames,
+           (double)calls / frames, (unsigned long long)(stream->stalls - stalls), (double)uploaded / BENCH_UPLOAD_TICKS);
+
+    free_bench_renderer(&renderer);
+    free_game(&game);
+}
+
+#define BENCH_CHECK_ALPHAS 3
+
+struct BoardCheck {
+    i32 width;
+    i32 height;
+    u32 length;
+    // Ticks taken after growing, each synced into the board texture as it happens.
+    i32 ticks;
+    bool32 grows_last_tick;
+    i32 zoom_steps;
+};
+
+static u8 instanced_pixels[BENCH_WINDOW_SIDE * BENCH_WINDOW_SIDE * 4];
+static u8 board_pixels[BENCH_WINDOW_SIDE * BENCH_WINDOW_SIDE * 4];
+
+static void write_capture(const char *dir, const char *name, const u8 *pixels) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ppm", dir, name);
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "can't write %s\n", path);
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", BENCH_WINDOW_SIDE, BENCH_WINDOW_SIDE);
+    // GL's rows run bottom up.
+    for (i32 y = BENCH_WINDOW_SIDE - 1; y >= 0; y--) {
+        for (i32 x = 0; x < BENCH_WINDOW_SIDE; x++) {
+            fwrite(pixels + (y * BENCH_WINDOW_SIDE + x) * 4, 1, 3, file);
+        }
+    }
+    fclose(file);
+}
+
+// Returns the pixels that differ over the check's frames.
+static u64 check_board_pass(const BoardCheck *check, const char *capture_dir) {
+    GameState game = {};
+    init_game(&game, check->width, check->height);
+    seed_game(&game, 1);
+    set_food_count(&game, MAX_FOOD);
+    restart_game(&game);
+    grow_snake(&game, check->length);
+
+    glm::ivec2 window_size = { BENCH_WINDOW_SIDE, BENCH_WINDOW_SIDE };
+    BenchRenderer renderer = {};
+    init_bench_renderer(&renderer, &game, true);
+    Camera camera = make_camera(&game.board);
+    camera_zoom(&camera, &game.board, check->zoom_steps);
+
+    SnakeMotion motion = {};
+    for (i32 tick = 0; tick < check->ticks; tick++) {
+        begin_snake_motion(&motion, &game.snake.tail);
+        step_snake(&game, check->grows_last_tick && tick == check->ticks - 1);
+        end_snake_motion(&motion, &game.board, &game.snake.tail, TICK_MOVED);
+        sync_board_pass(&renderer.board_pass, &game);
+    }
+
+    const float alphas[BENCH_CHECK_ALPHAS] = { 0.0f, 0.3f, 1.0f };
+    u64 differing = 0;
+    for (i32 i = 0; i < BENCH_CHECK_ALPHAS; i++) {
+        const SnakeMotion *frame_motion = check->ticks ? &motion : NULL;
+        camera_follow(&camera, snake_motion_head(frame_motion, &game.snake.tail, alphas[i]));
+        CameraView view = camera_view(&camera, &game.board, window_size);
+
+        draw_frame(&renderer, &game, &view, BENCH_BODY_VIEW, frame_motion, alphas[i]);
+        glReadPixels(0, 0, BENCH_WINDOW_SIDE, BENCH_WINDOW_SIDE, GL_RGBA, GL_UNSIGNED_BYTE, instanced_pixels);
+        draw_frame(&renderer, &game, &view, BENCH_BODY_BOARD, frame_motion, alphas[i]);
+        glReadPixels(0, 0, BENCH_WINDOW_SIDE, BENCH_WINDOW_SIDE, GL_RGBA, GL_UNSIGNED_BYTE, board_pixels);
+
+        u64 frame_differing = 0;
+        for (u32 pixel = 0; pixel < BENCH_WINDOW_SIDE * BENCH_WINDOW_SIDE; pixel++) {
+            frame_differing += memcmp(instanced_pixels + pixel * 4, board_pixels + pixel * 4, 4) != 0;
+        }
+        printf("%5dx%-5d %8u %5d %5d %-4s %5.2f %10llu\n", check->width, check->height, game.snake.tail.size,
+               check->ticks, check->zoom_steps, check->grows_last_tick ? "yes" : "no", alphas[i],
+               (unsigned long long)frame_differing);
+        differing += frame_differing;
+
+        if (capture_dir) {
+            char name[128];
+            snprintf(name, sizeof(name), "%dx%d_%u_%d_%d_%.2f", check->width, check->height, game.snake.tail.size,
+                     check->ticks, check->zoom_steps, alphas[i]);
+            char instanced_name[160], board_name[160];
+            snprintf(instanced_name, sizeof(instanced_name), "%s_instanced", name);
+            snprintf(board_name, sizeof(board_name), "%s_board", name);
+            write_capture(capture_dir, instanced_name, instanced_pixels);
+            write_capture(capture_dir, board_name, board_pixels);
+        }
+    }
+
+    free_bench_renderer(&renderer);
+    free_game(&game);
+    return differing;
+}
+
+i32 main(i32 argc, char **argv) {
+    const char *capture_dir = NULL;
+    for (i32 i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            capture_dir = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-c capture_dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!create_headless_context()) {
+        fprintf(stderr, "can't create a headless GL 3.3 context\n");
+        return 1;
+    }
+    printf("%s\n", (const char *)glGetString(GL_RENDERER));
+    count_gl_calls();
+
+    u32 framebuffer, color;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, BENCH_WINDOW_SIDE, BENCH_WINDOW_SIDE);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+
+    printf("%-11s %8s %-6s %8s %8s %-10s %10s %10s %11s %7s %7s\n", "board", "length", "body", "cells", "bridges",
+           "stream", "ms/frame", "submit ms", "calls/frame", "stalls", "B/tick");
+    for (i32 allow_persistent = 1; allow_persistent >= 0; allow_persistent--) {
+        bench_render(15, 200, 200, allow_persistent, false);
+        bench_render(64, 3000, 100, allow_persistent, false);
+        bench_render(1024, 100000, 50, allow_persistent, false);
+    }
+    bench_render(15, 200, 200, true, true);
+    bench_render(64, 3000, 100, true, true);
+    bench_render(1024, 100000, 50, true, true);
+
+    // Whole boards with their border, boards whose viewport doesn't fill the target, scrolling
+    // views across the wrap, zoomed in and out; frames at rest, while sliding and after growing.
+    const BoardCheck checks[] = {
+        { 15, 15, 200, 0, false, 0 },
+        { 15, 15, 40, 3, false, 0 },
+        { 15, 15, 40, 3, true, 0 },
+        { 37, 23, 300, 5, false, 0 },
+        { 64, 64, 3000, 0, false, 0 },
+        { 64, 64, 3000, 4, false, 0 },
+        { 64, 64, 3000, 4, false, 3 },
+        { 64, 64, 1000, 70, true, -2 },
+        { 1024, 1024, 100000, 0, false, 0 },
+        { 1024, 1024, 100000, 6, false, 0 },
+        { 1024, 1024, 5000, 1030, true, 6 },
+        { 1024, 1024, 100000, 6, false, -8 },
+    };
+    printf("\n%-11s %8s %5s %5s %-4s %5s %10s\n", "board", "length", "ticks", "zoom", "grew", "alpha", "differing");
+    u64 differing = 0;
+    for (u32 i = 0; i < ARR_SIZE(checks); i++) {
+        differing += check_board_pass(&checks[i], capture_dir);
+    }
+    printf("board pass: %llu pixels differ from the instanced renderer\n", (unsigned long long)differing);
+    return differing ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#include "../typedefs.h"
+#include "../game.h"
+#include "../snapshot.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Cost of cloning a game for search/rollback: save_snapshot into a preallocated buffer,
+// restore_snapshot back out of it, and the size of the portable encoding for comparison. Then a
+// check: decode_game_state round-trips a game in progress and rejects corrupt states. Exits
+// non-zero if the check fails.
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Grows the snake along a boustrophedon path (right on odd rows, left on even ones) until it
+// reaches `length`.
+static bool32 grow_snake(GameState *game, u32 length) {
+    while (game->snake.tail.size < length) {
+        glm::ivec2 head = tail_front(&game->snake.tail)->pos;
+        bool32 going_right = head.y & 1;
+        i32 direction = going_right ? DIRECTION_RIGHT : DIRECTION_LEFT;
+        if ((going_right && head.x == game->board.width - 1) || (!going_right && head.x == 0)) {
+            direction = DIRECTION_DOWN;
+        }
+
+        push_queue(&game->turns_queue, direction);
+        game->snake.should_grow = true;
+        if (update_snake(game) == TICK_DIED) return false;
+    }
+    return true;
+}
+
+static void bench_snapshot(i32 board, u32 length, i32 iterations) {
+    GameState game = {};
+    init_game(&game, board, board);
+    seed_game(&game, 1);
+    restart_game(&game);
+
+    if (!grow_snake(&game, length)) {
+        printf("%4dx%-4d %8u  (snake died while growing)\n", board, board, length);
+        free_game(&game);
+        return;
+    }
+
+    u8 *buffer = (u8 *)malloc(snapshot_capacity(&game));
+    u64 bytes = save_snapshot(&game, buffer);
+
+    ByteBuffer encoded = {};
+    encode_game_state(&encoded, &game);
+
+    double start = now_seconds();
+    for (i32 i = 0; i < iterations; i++) {
+        save_snapshot(&game, buffer);
+    }
+    double mid = now_seconds();
+    for (i32 i = 0; i < iterations; i++) {
+        restore_snapshot(&game, buffer);
+    }
+    double end = now_seconds();
+
+    double save_ns = (mid - start) * 1e9 / iterations;
+    double restore_ns = (end - mid) * 1e9 / iterations;
+    printf("%4dx%-4d %8u %10llu %10llu %10.1f %10.1f %12.0f\n", board, board, game.snake.tail.size,
+           (unsigned long long)bytes, (unsigned long long)encoded.size, save_ns, restore_ns,
+           1e9 / (save_ns + restore_ns));
+
+    free_buffer(&encoded);
+    free(buffer);
+    free_game(&game);
+}
+
+// Encodes `game` with `corrupt` applied and reports whether a fresh game decodes it; the game
+// is put back from a snapshot afterwards.
+template <typename Corrupt>
+static bool32 decodes(GameState *game, u8 *snapshot, Corrupt corrupt) {
+    save_snapshot(game, snapshot);
+    corrupt(game);
+    ByteBuffer encoded = {};
+    encode_game_state(&encoded, game);
+    restore_snapshot(game, snapshot);
+
+    GameState decoded = {};
+    init_game(&decoded, game->board.width, game->board.height);
+    ByteReader reader = make_reader(encoded.data, encoded.size);
+    bool32 ok = decode_game_state(&reader, &decoded);
+
+    free_game(&decoded);
+    free_buffer(&encoded);
+    return ok;
+}
+
+static bool32 check_decode() {
+    GameState game = {};
+    init_game(&game, 15, 15);
+    seed_game(&game, 2);
+    set_food_count(&game, 3);
+    restart_game(&game);
+    grow_snake(&game, 40);
+    u8 *snapshot = (u8 *)malloc(snapshot_capacity(&game));
+
+    u32 head_cell = board_index(&game.board, tail_front(&game.snake.tail)->pos);
+    u32 failures = 0;
+    failures += !decodes(&game, snapshot, [](GameState *) {});
+    failures += decodes(&game, snapshot, [](GameState *g) { g->food_count = -1; });
+    failures += decodes(&game, snapshot, [](GameState *g) { g->turns_queue.size = -1; });
+    failures += decodes(&game, snapshot, [](GameState *g) { g->cells_left++; });
+    failures += decodes(&game, snapshot, [&](GameState *g) { g->food_pos[0] = tail_at(&g->snake.tail, 1)->pos; });
+    failures += decodes(&game, snapshot, [&](GameState *g) { g->free_cells.cells[0] = head_cell; });
+    failures += decodes(&game, snapshot, [](GameState *g) { g->free_cells.cells[1] = g->free_cells.cells[0]; });
+    failures += decodes(&game, snapshot, [](GameState *g) { g->free_cells.region_free[0]--; });
+
+    printf("decode check: %u failures\n", failures);
+    free(snapshot);
+    free_game(&game);
+    return failures == 0;
+}
+
+i32 main() {
+    printf("%-9s %8s %10s %10s %10s %10s %12s\n", "board", "length", "bytes", "encoded", "save ns", "restore ns", "clones/sec");
+
+    const u32 small_lengths[] = { 3, 64, 192 };
+    for (i32 i = 0; i < ARR_SIZE(small_lengths); i++) {
+        bench_snapshot(15, small_lengths[i], 2000000);
+    }
+
+    const u32 large_lengths[] = { 3, 256, 1024, 3072 };
+    for (i32 i = 0; i < ARR_SIZE(large_lengths); i++) {
+        bench_snapshot(64, large_lengths[i], 200000);
+    }
+
+    return check_decode() ? 0 : 1;
+}
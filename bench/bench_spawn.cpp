@@ -0,0 +1,142 @@
+#include "../typedefs.h"
+#include "../board.h"
+#include "../game.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Cost of placing one food item as the board fills up, which stays flat because
+// free_cells_sample is a pick from a dense array. Then a check: a spawn region added to a game
+// in progress keeps the free-cell set exact, and food lands in each region in proportion to
+// its weight. Exits non-zero if the check fails.
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Marks cells occupied in a scattered order until only `free_count` are left, keeping the
+// free-cell set in step the way push_new_head does.
+static void fill_board(GameState *game, u32 free_count) {
+    u32 cell_count = game->board.cell_count;
+    u32 cell = 0;
+    for (u32 filled = cell_count - free_cells_total(&game->free_cells); filled < cell_count - free_count; filled++) {
+        while (map_at(&game->map, cell) || game->free_cells.slot[cell] == INVALID_SLOT) {
+            cell = (cell + 7919) % cell_count;
+        }
+        map_set(&game->map, cell, 1);
+        free_cells_remove(&game->free_cells, cell);
+    }
+}
+
+static double bench_spawn(i32 board, u32 free_count, i32 samples, u64 *checksum) {
+    GameState game = {};
+    init_game(&game, board, board);
+    seed_game(&game, 1);
+    restart_game(&game);
+    fill_board(&game, free_count);
+
+    double start = now_seconds();
+    for (i32 i = 0; i < samples; i++) {
+        *checksum += (u64)free_cells_sample(&game.free_cells, &game.rng);
+    }
+    double elapsed = now_seconds() - start;
+
+    free_game(&game);
+    return elapsed * 1e9 / samples;
+}
+
+// Counts the ways the free-cell set disagrees with the board: a cell in the set that's
+// occupied or holds food, a free cell missing from it, a slot outside its cell's region, or an
+// index that doesn't point back.
+static u32 count_free_cell_errors(GameState *game) {
+    FreeCellSet *set = &game->free_cells;
+    u32 errors = 0;
+    for (u32 cell = 0; cell < set->cell_count; cell++) {
+        bool32 should_be_free = !map_at(&game->map, cell) && food_at(game, board_position(&game->board, cell)) < 0;
+        u32 slot = set->slot[cell];
+        if (slot == INVALID_SLOT) {
+            errors += should_be_free;
+            continue;
+        }
+
+        u32 region = set->region_of[cell];
+        errors += !should_be_free;
+        errors += slot < set->region_start[region] || slot >= set->region_start[region] + set->region_free[region];
+        errors += set->cells[slot] != cell;
+    }
+    return errors;
+}
+
+// Samples `samples` cells and returns the share that land in `region`; every sample that isn't
+// a free cell counts as an error.
+static double sample_region_share(GameState *game, i32 region, i32 samples, u32 *errors) {
+    i32 hits = 0;
+    for (i32 i = 0; i < samples; i++) {
+        i32 cell = free_cells_sample(&game->free_cells, &game->rng);
+        if (cell < 0 || map_at(&game->map, (u32)cell) || food_at(game, board_position(&game->board, (u32)cell)) >= 0) {
+            (*errors)++;
+            continue;
+        }
+        hits += game->free_cells.region_of[cell] == region;
+    }
+    return (double)hits / samples;
+}
+
+static bool32 check_spawn_regions() {
+    const i32 board = 32;
+    const i32 samples = 200000;
+    GameState game = {};
+    init_game(&game, board, board);
+    seed_game(&game, 3);
+    set_food_count(&game, 4);
+    restart_game(&game);
+
+    // Play a while first so the set has been reshuffled by moves and meals.
+    u32 errors = 0;
+    for (i32 tick = 0; tick < 500; tick++) {
+        if (tick % 9 == 0) push_queue(&game.turns_queue, DIRECTION_UP + (tick / 9) % 2 * 2);
+        update_snake(&game);
+    }
+
+    // Weight 3 against the rest of the board's 1, while both have free cells.
+    i32 region = add_spawn_region(&game, { 4, 4 }, { 11, 11 }, 3);
+    errors += count_free_cell_errors(&game);
+    double share = sample_region_share(&game, region, samples, &errors);
+
+    // The rebuilt layout has to survive moves, meals and deaths too.
+    for (i32 tick = 0; tick < 2000; tick++) {
+        if (tick % 5 == 0) push_queue(&game.turns_queue, DIRECTION_UP + (tick / 5) % 4);
+        update_snake(&game);
+        errors += count_free_cell_errors(&game);
+    }
+
+    set_spawn_weight(&game.free_cells, region, 0);
+    double zero_share = sample_region_share(&game, region, samples, &errors);
+
+    printf("region share %.3f (want 0.750), at weight 0 %.3f (want 0.000), %u errors\n", share, zero_share, errors);
+    free_game(&game);
+    return errors == 0 && share > 0.74 && share < 0.76 && zero_share == 0.0;
+}
+
+i32 main() {
+    const i32 boards[] = { 64, 256, 1024 };
+    const double free_shares[] = { 0.5, 0.01, 0.0001 };
+    const i32 samples = 10000000;
+    u64 checksum = 0;
+
+    printf("%6s | %12s %12s %12s\n", "board", "50% free ns", "1% free ns", "0.01% ns");
+    for (i32 i = 0; i < ARR_SIZE(boards); i++) {
+        printf("%6d |", boards[i]);
+        for (i32 j = 0; j < ARR_SIZE(free_shares); j++) {
+            u32 free_count = (u32)(free_shares[j] * boards[i] * boards[i]);
+            printf(" %12.2f", bench_spawn(boards[i], free_count ? free_count : 1, samples, &checksum));
+        }
+        printf("\n");
+    }
+    printf("(checksum %llu)\n", (unsigned long long)checksum);
+
+    return check_spawn_regions() ? 0 : 1;
+}
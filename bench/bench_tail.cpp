@@ -0,0 +1,125 @@
+#include "../typedefs.h"
+#include "../tail_ring.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <deque>
+#include <stdio.h>
+
+// Long snakes on large boards: the body covers 3/4 of the board. "move" is one tick of
+// push_front + pop_back, "walk" is the per-segment cost of visiting the whole body the way
+// rebuild_body_index does.
+
+static glm::ivec2 next_pos(glm::ivec2 pos, i32 board) {
+    pos.x++;
+    if (pos.x == board) {
+        pos.x = 0;
+        pos.y = (pos.y + 1) % board;
+    }
+    return pos;
+}
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void bench_deque(i32 board, i32 length, i32 ticks, double *move_ns, double *walk_ns, i64 *checksum) {
+    std::deque<TailPiece> tail;
+    glm::ivec2 pos = {0, 0};
+    for (i32 i = 0; i < length; i++) {
+        tail.push_front({ pos });
+        pos = next_pos(pos, board);
+    }
+
+    i32 moves = ticks * 100;
+    double start = now_seconds();
+    for (i32 i = 0; i < moves; i++) {
+        tail.pop_back();
+        tail.push_front({ pos });
+        pos = next_pos(pos, board);
+    }
+    double mid = now_seconds();
+
+    for (i32 tick = 0; tick < ticks; tick++) {
+        for (auto it = tail.begin() + 1; it != tail.end(); ++it) {
+            glm::ivec2 d = (it - 1)->pos - it->pos;
+            *checksum += d.x + d.y;
+        }
+        tail.pop_back();
+        tail.push_front({ pos });
+        pos = next_pos(pos, board);
+    }
+    double end = now_seconds();
+
+    *move_ns = (mid - start) * 1e9 / moves;
+    *walk_ns = (end - mid) * 1e9 / ((double)ticks * length);
+}
+
+static void bench_ring(i32 board, i32 length, i32 ticks, double *move_ns, double *walk_ns, i64 *checksum) {
+    TailRing tail;
+    init_tail(&tail, board * board);
+    glm::ivec2 pos = {0, 0};
+    for (i32 i = 0; i < length; i++) {
+        tail_push_front(&tail, { pos });
+        pos = next_pos(pos, board);
+    }
+
+    i32 moves = ticks * 100;
+    double start = now_seconds();
+    for (i32 i = 0; i < moves; i++) {
+        tail_pop_back(&tail);
+        tail_push_front(&tail, { pos });
+        pos = next_pos(pos, board);
+    }
+    double mid = now_seconds();
+
+    for (i32 tick = 0; tick < ticks; tick++) {
+        TailSpans spans = tail_spans(&tail);
+        glm::ivec2 prev = spans.first[0].pos;
+        for (u32 i = 1; i < spans.first_count; i++) {
+            glm::ivec2 d = prev - spans.first[i].pos;
+            *checksum += d.x + d.y;
+            prev = spans.first[i].pos;
+        }
+        for (u32 i = 0; i < spans.second_count; i++) {
+            glm::ivec2 d = prev - spans.second[i].pos;
+            *checksum += d.x + d.y;
+            prev = spans.second[i].pos;
+        }
+        tail_pop_back(&tail);
+        tail_push_front(&tail, { pos });
+        pos = next_pos(pos, board);
+    }
+    double end = now_seconds();
+
+    *move_ns = (mid - start) * 1e9 / moves;
+    *walk_ns = (end - mid) * 1e9 / ((double)ticks * length);
+    free_tail(&tail);
+}
+
+i32 main() {
+    const i32 boards[] = { 64, 256, 1024 };
+    i64 checksum = 0;
+
+    printf("%6s %9s | %14s %14s | %14s %14s\n", "board", "length",
+           "deque move ns", "ring move ns", "deque walk ns", "ring walk ns");
+
+    for (i32 i = 0; i < ARR_SIZE(boards); i++) {
+        i32 board = boards[i];
+        i32 length = board * board / 4 * 3;
+        i32 ticks = (i32)(200000000LL / length);
+        if (ticks > 20000) ticks = 20000;
+        if (ticks < 100) ticks = 100;
+
+        double deque_move, deque_walk, ring_move, ring_walk;
+        bench_deque(board, length, ticks, &deque_move, &deque_walk, &checksum);
+        bench_ring(board, length, ticks, &ring_move, &ring_walk, &checksum);
+
+        printf("%6d %9d | %14.1f %14.1f | %14.3f %14.3f\n", board, length,
+               deque_move, ring_move, deque_walk, ring_walk);
+    }
+
+    printf("(checksum %lld)\n", (long long)checksum);
+    return 0;
+}
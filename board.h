@@ -0,0 +1,132 @@
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#include "typedefs.h"
+
+#include <glm/glm.hpp>
+#include <stdlib.h>
+
+#define BOARD_MIN_WIDTH 4
+#define BOARD_MIN_HEIGHT 2
+#define BOARD_MAX_SIDE 16384
+
+// Board sizes that get a compile-time specialized update_snake.
+#define HOT_BOARD_SIZES(X) \
+    X(15, 15)              \
+    X(32, 32)              \
+    X(64, 64)
+
+struct Board {
+    i32 width;
+    i32 height;
+    u32 cell_count;
+};
+
+Board make_board(i32 width, i32 height) {
+    Board board;
+    board.width = glm::clamp(width, BOARD_MIN_WIDTH, BOARD_MAX_SIDE);
+    board.height = glm::clamp(height, BOARD_MIN_HEIGHT, BOARD_MAX_SIDE);
+    board.cell_count = (u32)board.width * (u32)board.height;
+    return board;
+}
+
+// Accepts "N" for a square board or "WxH".
+bool32 parse_board_size(const char *text, i32 *width, i32 *height) {
+    char *end;
+    long w = strtol(text, &end, 10);
+    long h = w;
+    if (end == text) return false;
+    if (*end == 'x' || *end == 'X') {
+        const char *h_text = end + 1;
+        h = strtol(h_text, &end, 10);
+        if (end == h_text) return false;
+    }
+    if (*end != '\0' || w < BOARD_MIN_WIDTH || h < BOARD_MIN_HEIGHT || w > BOARD_MAX_SIDE || h > BOARD_MAX_SIDE) {
+        return false;
+    }
+
+    *width = (i32)w;
+    *height = (i32)h;
+    return true;
+}
+
+static u32 board_index(const Board *board, glm::ivec2 pos) {
+    return (u32)(pos.y * board->width + pos.x);
+}
+
+static glm::ivec2 board_position(const Board *board, u32 index) {
+    return { (i32)(index % (u32)board->width), (i32)(index / (u32)board->width) };
+}
+
+static glm::ivec2 board_wrap(const Board *board, glm::ivec2 pos) {
+    pos.x = pos.x < 0 ? board->width - 1 : (pos.x >= board->width ? 0 : pos.x);
+    pos.y = pos.y < 0 ? board->height - 1 : (pos.y >= board->height ? 0 : pos.y);
+    return pos;
+}
+
+// Shortest step between two cells that may sit on opposite edges of the torus.
+static glm::ivec2 board_wrap_delta(const Board *board, glm::ivec2 delta) {
+    if (delta.x >  board->width / 2)  delta.x -= board->width;
+    if (delta.x < -board->width / 2)  delta.x += board->width;
+    if (delta.y >  board->height / 2) delta.y -= board->height;
+    if (delta.y < -board->height / 2) delta.y += board->height;
+    return delta;
+}
+
+static i32 board_distance(const Board *board, glm::ivec2 a, glm::ivec2 b) {
+    glm::ivec2 delta = board_wrap_delta(board, b - a);
+    return glm::abs(delta).x + glm::abs(delta).y;
+}
+
+// The four cells around `cell` on the torus, in DIRECTION_UP..DIRECTION_LEFT order.
+static void board_neighbors(const Board *board, u32 cell, u32 neighbors[4]) {
+    u32 width = (u32)board->width;
+    u32 x = cell % width;
+    u32 last_row = board->cell_count - width;
+
+    neighbors[0] = cell < width ? cell + last_row : cell - width;
+    neighbors[1] = x == width - 1 ? cell - x : cell + 1;
+    neighbors[2] = cell >= last_row ? cell - last_row : cell + width;
+    neighbors[3] = x == 0 ? cell + width - 1 : cell - 1;
+}
+
+// Geometry policies for update_snake. RuntimeGeometry reads the board dimensions from the
+// game, FixedGeometry bakes them in and wraps through constexpr lookup tables.
+struct RuntimeGeometry {
+    const Board *board;
+
+    glm::ivec2 step(glm::ivec2 pos, glm::ivec2 velocity) const {
+        return board_wrap(board, pos + velocity);
+    }
+
+    u32 index(glm::ivec2 pos) const {
+        return board_index(board, pos);
+    }
+};
+
+template <i32 W, i32 H>
+struct FixedGeometry {
+    struct WrapTables {
+        i32 x[W + 2];
+        i32 y[H + 2];
+    };
+
+    static constexpr WrapTables make_wrap_tables() {
+        WrapTables tables = {};
+        for (i32 i = 0; i < W + 2; i++) tables.x[i] = (i - 1 + W) % W;
+        for (i32 i = 0; i < H + 2; i++) tables.y[i] = (i - 1 + H) % H;
+        return tables;
+    }
+
+    static constexpr WrapTables wrap = make_wrap_tables();
+
+    glm::ivec2 step(glm::ivec2 pos, glm::ivec2 velocity) const {
+        return { wrap.x[pos.x + velocity.x + 1], wrap.y[pos.y + velocity.y + 1] };
+    }
+
+    u32 index(glm::ivec2 pos) const {
+        return (u32)(pos.y * W + pos.x);
+    }
+};
+
+#endif
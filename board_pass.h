@@ -0,0 +1,257 @@
+#ifndef _BOARD_PASS_H_
+#define _BOARD_PASS_H_
+
+#include "typedefs.h"
+#include "object.h"
+#include "shader.h"
+#include "stream_buffer.h"
+#include "camera.h"
+#include "game.h"
+#include "snake.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <stdlib.h>
+#include <string.h>
+
+// The single game drawn in one fullscreen pass: the board goes up as an R8UI texture, one
+// texel per cell holding what's on it and which neighbours its body piece links to, and
+// board.frag works out every pixel from the cells around it. Draw cost doesn't depend on the
+// snake's length or the board's size, only on the pixels. A tick rewrites the few texels it
+// changed (the pushed head and the piece behind it, the popped tail, eaten and spawned food);
+// the whole texture goes up again when the body ring's generation changes, as for the body
+// mirror. The head and the tail tip's old cell move between cells while they slide, so they
+// come in BoardData instead.
+
+#define BOARD_CELL_EMPTY 0
+#define BOARD_CELL_FOOD 1
+#define BOARD_CELL_BODY 2
+#define BOARD_CELL_HEAD 3
+// Then one bit per direction of Direction, from up, for the pieces next to it along the body.
+#define BOARD_CELL_LINK_SHIFT 2
+
+// Ticks between two frames rarely change more than a handful of cells; past this many it's
+// cheaper to send the whole texture than to send them one by one.
+#define BOARD_PASS_MAX_DIRTY 256
+
+struct BoardPass {
+    ObjectData object;
+    u32 texture;
+    Board board;
+    u8 *cells;
+    u32 dirty[BOARD_PASS_MAX_DIRTY];
+    u32 dirty_count;
+    bool32 needs_full_upload;
+
+    // The ring and food as the texture last saw them.
+    u32 head;
+    u32 size;
+    u32 capacity;
+    u32 generation;
+    i32 food_count;
+    glm::ivec2 food_pos[MAX_FOOD];
+    bool32 is_valid;
+
+    float subpixel_scale;
+    u64 bytes_uploaded;
+    u64 full_uploads;
+};
+
+// False when the board is larger than the driver's textures can be; the instanced renderer
+// has to draw it then.
+bool32 init_board_pass(BoardPass *pass, const Board *board) {
+    *pass = {};
+    i32 max_side = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_side);
+    if (board->width > max_side || board->height > max_side) return false;
+
+    // board.frag snaps quad corners as the rasterizer does.
+    i32 subpixel_bits = 0;
+    glGetIntegerv(GL_SUBPIXEL_BITS, &subpixel_bits);
+    pass->subpixel_scale = (float)(1 << subpixel_bits);
+
+    pass->board = *board;
+    pass->cells = (u8 *)calloc(board->cell_count, 1);
+
+    glGenTextures(1, &pass->texture);
+    glBindTexture(GL_TEXTURE_2D, pass->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, board->width, board->height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // A fullscreen triangle with no attributes, see board.vert.
+    pass->object.vertex_count = 3;
+    pass->object.primitive = GL_TRIANGLES;
+    glGenVertexArrays(1, &pass->object.vao);
+    pass->object.shader = load_shader_program("./shaders/board.vert", "./shaders/board.frag");
+    glUseProgram(pass->object.shader.id);
+    glUniform1i(shader_uniform(&pass->object.shader, "board"), 0);
+    glUseProgram(0);
+    return true;
+}
+
+void free_board_pass(BoardPass *pass) {
+    glDeleteTextures(1, &pass->texture);
+    glDeleteVertexArrays(1, &pass->object.vao);
+    glDeleteProgram(pass->object.shader.id);
+    free(pass->cells);
+    *pass = {};
+}
+
+static u8 board_cell_link(const Board *board, glm::ivec2 from, glm::ivec2 to) {
+    i32 direction = velocity_to_direction(board_wrap_delta(board, to - from));
+    return direction ? (u8)(1 << (BOARD_CELL_LINK_SHIFT + direction - 1)) : 0;
+}
+
+static u8 board_piece_cell(const Board *board, TailRing *tail, u32 offset) {
+    glm::ivec2 pos = tail_at(tail, offset)->pos;
+    u8 cell = offset == 0 ? BOARD_CELL_HEAD : BOARD_CELL_BODY;
+    if (offset > 0) cell |= board_cell_link(board, pos, tail_at(tail, offset - 1)->pos);
+    if (offset + 1 < tail->size) cell |= board_cell_link(board, pos, tail_at(tail, offset + 1)->pos);
+    return cell;
+}
+
+static void set_board_cell(BoardPass *pass, glm::ivec2 pos, u8 cell) {
+    u32 index = board_index(&pass->board, pos);
+    pass->cells[index] = cell;
+    if (pass->dirty_count == BOARD_PASS_MAX_DIRTY) {
+        pass->needs_full_upload = true;
+        return;
+    }
+    pass->dirty[pass->dirty_count++] = index;
+}
+
+static bool32 has_food_at(const glm::ivec2 *food_pos, i32 food_count, glm::ivec2 pos) {
+    for (i32 i = 0; i < food_count; i++) {
+        if (food_pos[i] == pos) return true;
+    }
+    return false;
+}
+
+static void rebuild_board_cells(BoardPass *pass, GameState *game) {
+    TailRing *tail = &game->snake.tail;
+    memset(pass->cells, BOARD_CELL_EMPTY, pass->board.cell_count);
+    for (i32 i = 0; i < game->food_count; i++) {
+        pass->cells[board_index(&pass->board, game->food_pos[i])] = BOARD_CELL_FOOD;
+    }
+    for (u32 i = 0; i < tail->size; i++) {
+        pass->cells[board_index(&pass->board, tail_at(tail, i)->pos)] = board_piece_cell(&pass->board, tail, i);
+    }
+}
+
+// Brings the texture up to date with `game` and returns the bytes that took.
+u64 sync_board_pass(BoardPass *pass, GameState *game) {
+    u64 uploaded = pass->bytes_uploaded;
+    TailRing *tail = &game->snake.tail;
+    const Board *board = &pass->board;
+    u32 capacity = tail->mask + 1;
+    u32 pushed = (pass->head - tail->head) & tail->mask;
+
+    pass->dirty_count = 0;
+    pass->needs_full_upload = !pass->is_valid || pass->generation != tail->generation || pass->capacity != capacity ||
+                              pushed > tail->size || pushed + pass->size > capacity;
+    if (!pass->needs_full_upload) {
+        // Old piece k is piece pushed + k now, so those past the end were popped. Their slots
+        // haven't been pushed over yet, as the check above makes sure.
+        u32 first_popped = tail->size > pushed ? tail->size - pushed : 0;
+        for (u32 k = first_popped; k < pass->size; k++) {
+            set_board_cell(pass, tail->data[(pass->head + k) & tail->mask].pos, BOARD_CELL_EMPTY);
+        }
+        for (i32 i = 0; i < pass->food_count; i++) {
+            if (!has_food_at(game->food_pos, game->food_count, pass->food_pos[i])) {
+                set_board_cell(pass, pass->food_pos[i], BOARD_CELL_EMPTY);
+            }
+        }
+
+        // The new pieces, the old head that now links to them, and the new tail tip that lost
+        // its link to the popped piece.
+        if (tail->size && pushed) {
+            u32 last_changed = pushed < tail->size - 1 ? pushed : tail->size - 1;
+            for (u32 i = 0; i <= last_changed; i++) {
+                set_board_cell(pass, tail_at(tail, i)->pos, board_piece_cell(board, tail, i));
+            }
+            if (pushed + pass->size > tail->size && last_changed < tail->size - 1) {
+                set_board_cell(pass, tail_back(tail)->pos, board_piece_cell(board, tail, tail->size - 1));
+            }
+        }
+
+        for (i32 i = 0; i < game->food_count; i++) {
+            if (!has_food_at(pass->food_pos, pass->food_count, game->food_pos[i])) {
+                set_board_cell(pass, game->food_pos[i], BOARD_CELL_FOOD);
+            }
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, pass->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (pass->needs_full_upload) {
+        rebuild_board_cells(pass, game);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, board->width, board->height, GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                        pass->cells);
+        pass->bytes_uploaded += board->cell_count;
+        pass->full_uploads++;
+    } else {
+        for (u32 i = 0; i < pass->dirty_count; i++) {
+            glm::ivec2 pos = board_position(board, pass->dirty[i]);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                            pass->cells + pass->dirty[i]);
+        }
+        pass->bytes_uploaded += pass->dirty_count;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    pass->head = tail->head;
+    pass->size = tail->size;
+    pass->capacity = capacity;
+    pass->generation = tail->generation;
+    pass->food_count = game->food_count;
+    memcpy(pass->food_pos, game->food_pos, sizeof(pass->food_pos));
+    pass->is_valid = true;
+    return pass->bytes_uploaded - uploaded;
+}
+
+// Draws food, body and, for a view of the whole board, the border, in place of the instance
+// batch and grid. The texture must be synced with `game`, and FrameData bound for `view`.
+// Writes BoardData into the stream, so the frame has to reserve room for it.
+void render_board_pass(BoardPass *pass, StreamBuffer *stream, GameState *game, const CameraView *view,
+                       glm::vec3 color, const SnakeMotion *motion, float alpha) {
+    TailRing *tail = &game->snake.tail;
+    const Board *board = &pass->board;
+    bool32 is_moving = motion && motion->is_valid;
+
+    BoardData data = {};
+    data.board_size = glm::ivec2(board->width, board->height);
+    data.view_min = view->min;
+    data.view_max = view->max;
+
+    // Placed as push_snake places them.
+    glm::ivec2 at;
+    if (tail->size && camera_unwrap(view, board, tail_front(tail)->pos, &at)) {
+        data.has_head = true;
+        data.head_at = glm::vec2(at);
+        if (is_moving) data.head_at -= glm::vec2(motion->head_step) * (1.0f - alpha);
+        if (tail->size > 1) data.head_link = board_wrap_delta(board, tail_at(tail, 1)->pos - tail_front(tail)->pos);
+    }
+    if (is_moving && motion->has_tail_moved && camera_unwrap(view, board, tail_back(tail)->pos, &at)) {
+        data.tail_at = glm::vec2(at) - glm::vec2(motion->tail_step) * (1.0f - alpha);
+        data.tail_step = motion->tail_step;
+    }
+
+    data.has_border = view->is_whole_board;
+    data.viewport = glm::vec4((float)view->viewport_pos.x, (float)view->viewport_pos.y, (float)view->viewport_size.x,
+                              (float)view->viewport_size.y);
+    data.head_color = glm::vec4(color, 1.0f);
+    data.body_color = glm::vec4(0.7f * color.x, 0.7f * color.y, 0.7f * color.z, 1.0f);
+    data.food_color = glm::vec4(FOOD_COLOR, 1.0f);
+    data.subpixel_scale = pass->subpixel_scale;
+    bind_uniform_block(stream, BOARD_DATA_BINDING, &data, sizeof(BoardData));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pass->texture);
+    render_object(&pass->object);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _BODY_H_
+#define _BODY_H_
+
+#include "object.h"
+#include "shader.h"
+
+// Programs that draw a snake straight from its BodyMirror. They build their quads from
+// gl_VertexID like cell.vert and bridge.vert, so their VAOs hold no attributes at all, and
+// everything about the snake but its pieces comes in the BodyData block.
+
+static ObjectData configure_body_object(const char *vertex_path, const char *fragment_path) {
+    ObjectData object = {};
+    object.vertex_count = 4;
+    object.primitive = GL_TRIANGLE_STRIP;
+    glGenVertexArrays(1, &object.vao);
+
+    // The mirror's texture is bound to unit 0 when drawing.
+    object.shader = load_shader_program(vertex_path, fragment_path);
+    glUseProgram(object.shader.id);
+    glUniform1i(shader_uniform(&object.shader, "body"), 0);
+    glUseProgram(0);
+
+    return object;
+}
+
+ObjectData configure_body_cell() {
+    return configure_body_object("./shaders/body_cell.vert", "./shaders/cell.frag");
+}
+
+ObjectData configure_body_bridge() {
+    return configure_body_object("./shaders/body_bridge.vert", "./shaders/bridge.frag");
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef _BODY_MIRROR_H_
+#define _BODY_MIRROR_H_
+
+#include "typedefs.h"
+#include "tail_ring.h"
+#include "stream_buffer.h"
+
+#include <glad/glad.h>
+
+// A copy of a snake's body ring on the GPU, slot for slot, in a buffer texture of RG32I
+// positions the body shaders read by piece: slot (head + i) & mask is piece i. A tick only
+// writes the head it pushed, as popping the tail just shrinks the live range, so keeping the
+// copy current costs sizeof(TailPiece) per tick whatever the length. The whole ring goes up
+// again only when the ring's generation changes: a restart, a load, or growing the ring.
+//
+// Earlier frames' draws may still be reading the mirror, so it is never written from the CPU in
+// place. Pushed slots go into the frame's fenced StreamBuffer region and the GPU copies them
+// across after those draws; a whole upload orphans the storage first.
+
+struct BodyMirror {
+    u32 buffer;
+    u32 texture;
+    u32 capacity;
+    u32 head;
+    u32 generation;
+    bool32 is_valid;
+
+    u64 bytes_uploaded;
+    u64 full_uploads;
+};
+
+void init_body_mirror(BodyMirror *mirror) {
+    *mirror = {};
+    glGenBuffers(1, &mirror->buffer);
+    glGenTextures(1, &mirror->texture);
+}
+
+void free_body_mirror(BodyMirror *mirror) {
+    glDeleteTextures(1, &mirror->texture);
+    glDeleteBuffers(1, &mirror->buffer);
+    *mirror = {};
+}
+
+// A range of slots splits in two where it wraps past the end of the ring.
+static u32 body_slots_before_wrap(TailRing *tail, u32 first, u32 count) {
+    u32 until_wrap = tail->mask + 1 - first;
+    return count < until_wrap ? count : until_wrap;
+}
+
+static bool32 needs_full_body_upload(BodyMirror *mirror, TailRing *tail) {
+    u32 pushed = (mirror->head - tail->head) & tail->mask;
+    return !mirror->is_valid || mirror->generation != tail->generation || mirror->capacity != tail->mask + 1 ||
+           pushed > tail->size;
+}
+
+// Stream space the next sync_body_mirror takes, for the frame's begin_stream_frame.
+u64 body_mirror_stream_bytes(BodyMirror *mirror, TailRing *tail, const StreamBuffer *stream) {
+    if (needs_full_body_upload(mirror, tail)) return 0;
+
+    u32 pushed = (mirror->head - tail->head) & tail->mask;
+    u32 first_count = body_slots_before_wrap(tail, tail->head, pushed);
+    u64 bytes = first_count ? stream_space(stream, first_count * sizeof(TailPiece)) : 0;
+    if (pushed > first_count) bytes += stream_space(stream, (pushed - first_count) * sizeof(TailPiece));
+    return bytes;
+}
+
+static void stream_body_slots(BodyMirror *mirror, StreamBuffer *stream, TailRing *tail, u32 first, u32 count) {
+    i64 offset = stream_write(stream, tail->data + first, count * sizeof(TailPiece));
+    if (offset < 0) {
+        // Not reserved; the next sync uploads the ring whole rather than drop the slots.
+        mirror->is_valid = false;
+        return;
+    }
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_TEXTURE_BUFFER, (GLintptr)offset, first * sizeof(TailPiece),
+                        count * sizeof(TailPiece));
+    mirror->bytes_uploaded += count * sizeof(TailPiece);
+}
+
+// Brings the copy up to date with `tail` and returns the bytes that took. Called between
+// begin_stream_frame and end_stream_frame, with body_mirror_stream_bytes counted in the first.
+u64 sync_body_mirror(BodyMirror *mirror, TailRing *tail, StreamBuffer *stream) {
+    u64 uploaded = mirror->bytes_uploaded;
+    u32 capacity = tail->mask + 1;
+    u32 pushed = (mirror->head - tail->head) & tail->mask;
+
+    glBindBuffer(GL_TEXTURE_BUFFER, mirror->buffer);
+    if (needs_full_body_upload(mirror, tail)) {
+        glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(TailPiece), NULL, GL_DYNAMIC_DRAW);
+        if (mirror->capacity != capacity) {
+            glBindTexture(GL_TEXTURE_BUFFER, mirror->texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, mirror->buffer);
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+            mirror->capacity = capacity;
+        }
+
+        u32 first_count = body_slots_before_wrap(tail, tail->head, tail->size);
+        glBufferSubData(GL_TEXTURE_BUFFER, tail->head * sizeof(TailPiece), first_count * sizeof(TailPiece),
+                        tail->data + tail->head);
+        if (tail->size > first_count) {
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, (tail->size - first_count) * sizeof(TailPiece), tail->data);
+        }
+        mirror->bytes_uploaded += tail->size * sizeof(TailPiece);
+        mirror->generation = tail->generation;
+        mirror->is_valid = true;
+        mirror->full_uploads++;
+    } else if (pushed) {
+        glBindBuffer(GL_COPY_READ_BUFFER, stream->buffer);
+        u32 first_count = body_slots_before_wrap(tail, tail->head, pushed);
+        stream_body_slots(mirror, stream, tail, tail->head, first_count);
+        if (pushed > first_count) stream_body_slots(mirror, stream, tail, 0, pushed - first_count);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    mirror->head = tail->head;
+    return mirror->bytes_uploaded - uploaded;
+}
+
+#endif
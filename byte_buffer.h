@@ -0,0 +1,124 @@
+#ifndef _BYTE_BUFFER_H_
+#define _BYTE_BUFFER_H_
+
+#include "typedefs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Growable byte array for building binary files in memory. Multi-byte values are written
+// little-endian.
+struct ByteBuffer {
+    u8 *data;
+    u64 size;
+    u64 capacity;
+};
+
+void free_buffer(ByteBuffer *buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+static void buffer_reserve(ByteBuffer *buffer, u64 extra) {
+    if (buffer->size + extra <= buffer->capacity) return;
+
+    u64 capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < buffer->size + extra) capacity *= 2;
+    buffer->data = (u8 *)realloc(buffer->data, capacity);
+    buffer->capacity = capacity;
+}
+
+static void write_bytes(ByteBuffer *buffer, const void *bytes, u64 count) {
+    buffer_reserve(buffer, count);
+    memcpy(buffer->data + buffer->size, bytes, count);
+    buffer->size += count;
+}
+
+static void write_u8(ByteBuffer *buffer, u8 value) {
+    buffer_reserve(buffer, 1);
+    buffer->data[buffer->size++] = value;
+}
+
+static void write_u32(ByteBuffer *buffer, u32 value) {
+    u8 bytes[4];
+    for (i32 i = 0; i < 4; i++) bytes[i] = (u8)(value >> (8 * i));
+    write_bytes(buffer, bytes, 4);
+}
+
+static void write_u64(ByteBuffer *buffer, u64 value) {
+    u8 bytes[8];
+    for (i32 i = 0; i < 8; i++) bytes[i] = (u8)(value >> (8 * i));
+    write_bytes(buffer, bytes, 8);
+}
+
+// LEB128: 7 bits per byte, high bit set on every byte but the last.
+static void write_varint(ByteBuffer *buffer, u64 value) {
+    buffer_reserve(buffer, 10);
+    while (value >= 0x80) {
+        buffer->data[buffer->size++] = (u8)(value | 0x80);
+        value >>= 7;
+    }
+    buffer->data[buffer->size++] = (u8)value;
+}
+
+// Reads walk a [cursor, end) range and set `ok` to false instead of running past the end.
+struct ByteReader {
+    const u8 *cursor;
+    const u8 *end;
+    bool32 ok;
+};
+
+static ByteReader make_reader(const u8 *data, u64 size) {
+    return { data, data + size, true };
+}
+
+static void read_bytes(ByteReader *reader, void *bytes, u64 count) {
+    if ((u64)(reader->end - reader->cursor) < count) {
+        reader->ok = false;
+        memset(bytes, 0, count);
+        return;
+    }
+    memcpy(bytes, reader->cursor, count);
+    reader->cursor += count;
+}
+
+static u8 read_u8(ByteReader *reader) {
+    u8 value;
+    read_bytes(reader, &value, 1);
+    return value;
+}
+
+static u32 read_u32(ByteReader *reader) {
+    u8 bytes[4];
+    read_bytes(reader, bytes, 4);
+    u32 value = 0;
+    for (i32 i = 0; i < 4; i++) value |= (u32)bytes[i] << (8 * i);
+    return value;
+}
+
+static u64 read_u64(ByteReader *reader) {
+    u8 bytes[8];
+    read_bytes(reader, bytes, 8);
+    u64 value = 0;
+    for (i32 i = 0; i < 8; i++) value |= (u64)bytes[i] << (8 * i);
+    return value;
+}
+
+static u64 read_varint(ByteReader *reader) {
+    u64 value = 0;
+    for (i32 shift = 0; shift < 64; shift += 7) {
+        if (reader->cursor >= reader->end) {
+            reader->ok = false;
+            return 0;
+        }
+        u8 byte = *reader->cursor++;
+        value |= (u64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    reader->ok = false;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef _CAMERA_H_
+#define _CAMERA_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <math.h>
+
+// Follows the head across boards too large to fit the window. Geometry lives in world units
+// of CAMERA_CELL_SIZE per cell, so cell and bridge meshes are built once and zooming only
+// changes the projection. Boards that fit are shown whole and centred, as before.
+//
+// View bounds are unwrapped cell coordinates: near an edge they run past the board and the
+// renderer wraps them back, so the torus scrolls without a seam.
+
+#define CAMERA_CELL_SIZE 64.0f
+#define CAMERA_DEFAULT_ZOOM 32.0f
+#define CAMERA_MIN_ZOOM 8.0f
+#define CAMERA_ZOOM_STEP 1.25f
+
+struct Camera {
+    glm::vec2 center;
+    float zoom;
+};
+
+struct CameraView {
+    glm::ivec2 min;
+    glm::ivec2 max;
+    glm::ivec2 viewport_pos;
+    glm::ivec2 viewport_size;
+    glm::mat4 projection;
+    bool32 is_whole_board;
+};
+
+Camera make_camera(const Board *board) {
+    Camera camera;
+    camera.center = glm::vec2(board->width / 2.0f, board->height / 2.0f);
+    camera.zoom = CAMERA_DEFAULT_ZOOM;
+    return camera;
+}
+
+// `steps` > 0 zooms in. Zooming out stops once the whole board fits.
+void camera_zoom(Camera *camera, const Board *board, i32 steps) {
+    float max_zoom = (float)glm::max(board->width, board->height);
+    camera->zoom = glm::clamp(camera->zoom * powf(CAMERA_ZOOM_STEP, (float)-steps), CAMERA_MIN_ZOOM, max_zoom);
+}
+
+// `head` is in cells and may sit between two of them while the snake moves.
+void camera_follow(Camera *camera, glm::vec2 head) {
+    camera->center = glm::vec2(head.x + 0.5f, head.y + 0.5f);
+}
+
+CameraView camera_view(Camera *camera, const Board *board, glm::ivec2 window_size) {
+    CameraView view;
+    float short_side = (float)glm::min(window_size.x, window_size.y);
+    float cell_pixels = short_side / camera->zoom;
+    glm::vec2 visible = glm::vec2(window_size.x / cell_pixels, window_size.y / cell_pixels);
+
+    if (visible.x >= board->width && visible.y >= board->height) {
+        cell_pixels = glm::min((float)window_size.x / board->width, (float)window_size.y / board->height);
+        view.viewport_size = glm::ivec2((i32)(cell_pixels * board->width), (i32)(cell_pixels * board->height));
+        view.viewport_pos = glm::ivec2((window_size.x - view.viewport_size.x) / 2, (window_size.y - view.viewport_size.y) / 2);
+        view.min = glm::ivec2(0, 0);
+        view.max = glm::ivec2(board->width - 1, board->height - 1);
+        view.projection = glm::ortho(0.0f, board->width * CAMERA_CELL_SIZE, 0.0f, board->height * CAMERA_CELL_SIZE);
+        view.is_whole_board = true;
+        return view;
+    }
+
+    // An axis that fits is pinned to the board so it doesn't show the same cells twice.
+    glm::vec2 center = camera->center;
+    if (visible.x >= board->width) center.x = board->width / 2.0f;
+    if (visible.y >= board->height) center.y = board->height / 2.0f;
+
+    float left = center.x - visible.x / 2, right = center.x + visible.x / 2;
+    float top = center.y - visible.y / 2, bottom = center.y + visible.y / 2;
+
+    view.viewport_pos = glm::ivec2(0, 0);
+    view.viewport_size = window_size;
+    view.min = glm::ivec2((i32)floorf(left), (i32)floorf(top));
+    view.max = glm::ivec2((i32)floorf(right), (i32)floorf(bottom));
+    if (visible.x >= board->width) view.min.x = 0, view.max.x = board->width - 1;
+    if (visible.y >= board->height) view.min.y = 0, view.max.y = board->height - 1;
+
+    // The shaders flip y after projecting, so `top` goes in the bottom slot.
+    view.projection = glm::ortho(left * CAMERA_CELL_SIZE, right * CAMERA_CELL_SIZE, top * CAMERA_CELL_SIZE,
+                                 bottom * CAMERA_CELL_SIZE);
+    view.is_whole_board = false;
+    return view;
+}
+
+void apply_camera_view(CameraView *view, FrameData *frame, StreamBuffer *stream) {
+    glViewport(view->viewport_pos.x, view->viewport_pos.y, view->viewport_size.x, view->viewport_size.y);
+    frame->projection = view->projection;
+    bind_uniform_block(stream, FRAME_DATA_BINDING, frame, sizeof(FrameData));
+}
+
+// The copy of board cell `pos` that falls inside the view, if any.
+static bool32 camera_unwrap(const CameraView *view, const Board *board, glm::ivec2 pos, glm::ivec2 *out) {
+    i32 x = view->min.x + ((pos.x - view->min.x) % board->width + board->width) % board->width;
+    i32 y = view->min.y + ((pos.y - view->min.y) % board->height + board->height) % board->height;
+    *out = glm::ivec2(x, y);
+    return x <= view->max.x && y <= view->max.y;
+}
+
+// Wraps an unwrapped view coordinate back onto the board.
+static glm::ivec2 camera_wrap(const Board *board, glm::ivec2 pos) {
+    pos.x %= board->width;
+    pos.y %= board->height;
+    if (pos.x < 0) pos.x += board->width;
+    if (pos.y < 0) pos.y += board->height;
+    return pos;
+}
+
+#endif
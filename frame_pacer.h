@@ -0,0 +1,124 @@
+#ifndef _FRAME_PACER_H_
+#define _FRAME_PACER_H_
+
+#include "typedefs.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Paces frames against absolute deadlines on the monotonic clock: frame N is due at
+// start + N * period, so rounding and late wake-ups don't accumulate. The pacer sleeps until
+// `spin_ns` before the deadline and busy-waits the rest, trading a little CPU for the
+// scheduler's wake-up latency. A frame that runs more than a whole period late restarts the
+// schedule from now instead of rushing to catch up.
+//
+// Each wait records how far past its deadline it woke (overshoot), how far the schedule has
+// slipped from the original one (drift, grows only on resyncs) and the frame time, start to
+// start, in a histogram of FRAME_HISTOGRAM_BUCKET_NS buckets.
+
+#define FRAME_PACER_DEFAULT_SPIN_NS 200000ull
+#define FRAME_HISTOGRAM_BUCKET_NS 10000ull
+#define FRAME_HISTOGRAM_BUCKETS 4096
+
+struct FramePacer {
+    u64 period_ns;
+    u64 spin_ns;
+    u64 start_ns;
+    u64 deadline_ns;
+    u64 last_frame_ns;
+
+    u64 frames;
+    u64 resyncs;
+    u64 overshoot_ns;
+    u64 max_overshoot_ns;
+    i64 drift_ns;
+    // The last bucket also counts every longer frame.
+    u32 histogram[FRAME_HISTOGRAM_BUCKETS];
+};
+
+void init_frame_pacer(FramePacer *pacer, u32 frame_rate, u64 spin_ns) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->period_ns = 1000000000ull / (frame_rate ? frame_rate : 1);
+    pacer->spin_ns = spin_ns;
+    pacer->start_ns = platform_time_ns();
+    pacer->deadline_ns = pacer->start_ns + pacer->period_ns;
+    pacer->last_frame_ns = pacer->start_ns;
+}
+
+void record_frame_time(FramePacer *pacer, u64 frame_ns) {
+    u64 bucket = frame_ns / FRAME_HISTOGRAM_BUCKET_NS;
+    pacer->histogram[bucket < FRAME_HISTOGRAM_BUCKETS ? bucket : FRAME_HISTOGRAM_BUCKETS - 1]++;
+    pacer->frames++;
+}
+
+// Blocks until the next frame is due.
+void wait_for_next_frame(FramePacer *pacer) {
+    u64 deadline = pacer->deadline_ns;
+    u64 now = platform_time_ns();
+
+    if (now < deadline) {
+        if (deadline - now > pacer->spin_ns) platform_sleep_until_ns(deadline - pacer->spin_ns);
+        while ((now = platform_time_ns()) < deadline) {}
+
+        u64 overshoot = now - deadline;
+        pacer->overshoot_ns += overshoot;
+        if (overshoot > pacer->max_overshoot_ns) pacer->max_overshoot_ns = overshoot;
+    }
+
+    if (now > deadline && now - deadline >= pacer->period_ns) {
+        pacer->deadline_ns = now + pacer->period_ns;
+        pacer->resyncs++;
+    } else {
+        pacer->deadline_ns = deadline + pacer->period_ns;
+    }
+
+    record_frame_time(pacer, now - pacer->last_frame_ns);
+    pacer->last_frame_ns = now;
+    pacer->drift_ns = (i64)(pacer->deadline_ns - pacer->start_ns) - (i64)((pacer->frames + 1) * pacer->period_ns);
+}
+
+// For frames something else paces, like vsync: records the frame time without waiting, so the
+// histogram covers them too.
+void record_frame(FramePacer *pacer) {
+    u64 now = platform_time_ns();
+    record_frame_time(pacer, now - pacer->last_frame_ns);
+    pacer->last_frame_ns = now;
+}
+
+// Frame time at percentile `p` (0..1), to bucket resolution.
+u64 frame_time_percentile(const FramePacer *pacer, double p) {
+    u64 target = (u64)(p * pacer->frames);
+    u64 seen = 0;
+    for (u32 i = 0; i < FRAME_HISTOGRAM_BUCKETS; i++) {
+        seen += pacer->histogram[i];
+        if (seen > target) return i * FRAME_HISTOGRAM_BUCKET_NS;
+    }
+    return (FRAME_HISTOGRAM_BUCKETS - 1) * FRAME_HISTOGRAM_BUCKET_NS;
+}
+
+// Deviation of frame time from the period at percentile `p`: buckets are taken outward from
+// the period's, nearest first, until `p` of the frames are covered.
+u64 frame_jitter_percentile(const FramePacer *pacer, double p) {
+    u64 target = (u64)(p * pacer->frames);
+    i64 center = (i64)(pacer->period_ns / FRAME_HISTOGRAM_BUCKET_NS);
+    u64 seen = 0;
+    for (i64 distance = 0; distance < FRAME_HISTOGRAM_BUCKETS; distance++) {
+        if (center + distance < FRAME_HISTOGRAM_BUCKETS) seen += pacer->histogram[center + distance];
+        if (distance > 0 && center - distance >= 0) seen += pacer->histogram[center - distance];
+        if (seen > target) return (u64)distance * FRAME_HISTOGRAM_BUCKET_NS;
+    }
+    return FRAME_HISTOGRAM_BUCKETS * FRAME_HISTOGRAM_BUCKET_NS;
+}
+
+void print_frame_pacer_report(const FramePacer *pacer) {
+    if (!pacer->frames) return;
+    printf("%llu frames at %.3f ms: interval p50 %.3f ms, p99 %.3f ms; jitter p50 %.3f ms, p99 %.3f ms; "
+           "max overshoot %.3f ms, %llu resyncs\n",
+           (unsigned long long)pacer->frames, pacer->period_ns / 1e6, frame_time_percentile(pacer, 0.5) / 1e6,
+           frame_time_percentile(pacer, 0.99) / 1e6, frame_jitter_percentile(pacer, 0.5) / 1e6,
+           frame_jitter_percentile(pacer, 0.99) / 1e6, pacer->max_overshoot_ns / 1e6,
+           (unsigned long long)pacer->resyncs);
+}
+
+#endif
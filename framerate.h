@@ -5,25 +5,114 @@
 #include "platform.h"
 
 #include <GLFW/glfw3.h>
+#include <stdio.h>
 
-struct FramerateData {
-    u32 fps;
-    u32 prev_time;
-    u32 current_time;
-    i32 time_slept;
+// Runs the simulation at a fixed tick rate whatever the frame rate. Real time builds up in an
+// accumulator and is spent in whole ticks; what's left over says how far the frame is into the
+// next tick, for interpolation. After a long stall at most TICK_CLOCK_MAX_CATCH_UP ticks run
+// and the rest is dropped, rather than the game fast-forwarding.
+
+#define TICK_CLOCK_MAX_CATCH_UP 8
+
+struct TickClock {
+    u64 tick_ns;
+    u64 accumulator_ns;
+    u64 last_ns;
+};
+
+void init_tick_clock(TickClock *clock, u32 tick_rate) {
+    clock->tick_ns = 1000000000ull / (tick_rate ? tick_rate : 1);
+    clock->accumulator_ns = 0;
+    clock->last_ns = platform_time_ns();
+}
+
+// Returns how many ticks are due. Time spent stopped is not accumulated, so a paused game
+// resumes where it left off.
+u32 advance_tick_clock(TickClock *clock, bool32 is_running) {
+    u64 now = platform_time_ns();
+    if (is_running) clock->accumulator_ns += now - clock->last_ns;
+    clock->last_ns = now;
+
+    u64 due = clock->accumulator_ns / clock->tick_ns;
+    if (due > TICK_CLOCK_MAX_CATCH_UP) {
+        due = TICK_CLOCK_MAX_CATCH_UP;
+        clock->accumulator_ns = due * clock->tick_ns;
+    }
+    clock->accumulator_ns -= due * clock->tick_ns;
+    return (u32)due;
+}
+
+// Fraction of the next tick already elapsed, in [0, 1).
+float tick_clock_alpha(TickClock *clock) {
+    return (float)((double)clock->accumulator_ns / (double)clock->tick_ns);
+}
+
+// Frame time (start to start) and tick time (simulation work only), averaged over about a
+// second and shown in the window title, with how long input events waited from capture to the
+// tick that applied them.
+
+#define FRAME_STATS_INTERVAL_NS 1000000000ull
+
+struct FrameStats {
+    u64 window_start;
+    u64 frame_start;
+    u64 frame_ns;
+    u64 tick_ns;
+    u64 upload_bytes;
+    u64 input_latency_ns;
+    u64 max_input_latency_ns;
+    u32 frames;
+    u32 ticks;
+    u32 inputs;
 };
 
-void wait_until_next_frame(FramerateData *fr) {
-    fr->current_time = (u32)(glfwGetTime() * 1000);
-    u32 time_taken = fr->current_time - fr->prev_time - fr->time_slept;
-    fr->prev_time = fr->current_time;
+void begin_frame_stats(FrameStats *stats) {
+    u64 now = platform_time_ns();
+    if (stats->frame_start) {
+        stats->frame_ns += now - stats->frame_start;
+        stats->frames++;
+    } else {
+        stats->window_start = now;
+    }
+    stats->frame_start = now;
+}
+
+void add_tick_time(FrameStats *stats, u64 tick_ns) {
+    stats->tick_ns += tick_ns;
+    stats->ticks++;
+}
+
+void add_upload_bytes(FrameStats *stats, u64 bytes) {
+    stats->upload_bytes += bytes;
+}
+
+void add_input_latency(FrameStats *stats, u64 latency_ns) {
+    stats->input_latency_ns += latency_ns;
+    if (latency_ns > stats->max_input_latency_ns) stats->max_input_latency_ns = latency_ns;
+    stats->inputs++;
+}
+
+void report_frame_stats(FrameStats *stats, GLFWwindow *window, const char *title) {
+    if (stats->frame_start - stats->window_start < FRAME_STATS_INTERVAL_NS || !stats->frames) return;
 
-    fr->time_slept = 1000 / fr->fps - time_taken;
-    if (fr->time_slept < 0) {
-        fr->time_slept = 0;
+    char text[224];
+    i32 length = snprintf(text, sizeof(text), "%s - frame %.2f ms (%.0f fps), tick %.3f ms", title,
+                          stats->frame_ns / 1e6 / stats->frames, stats->frames * 1e9 / stats->frame_ns,
+                          stats->ticks ? stats->tick_ns / 1e6 / stats->ticks : 0.0);
+    if (stats->ticks && stats->upload_bytes && length > 0 && length < (i32)sizeof(text)) {
+        length += snprintf(text + length, sizeof(text) - length, ", upload %.0f B/tick",
+                           (double)stats->upload_bytes / stats->ticks);
+    }
+    if (stats->inputs && length > 0 && length < (i32)sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, ", input %.1f ms (max %.1f)",
+                 stats->input_latency_ns / 1e6 / stats->inputs, stats->max_input_latency_ns / 1e6);
     }
+    glfwSetWindowTitle(window, text);
 
-    platform_sleep(fr->time_slept);
+    stats->window_start = stats->frame_start;
+    stats->frame_ns = stats->tick_ns = stats->upload_bytes = 0;
+    stats->input_latency_ns = stats->max_input_latency_ns = 0;
+    stats->frames = stats->ticks = stats->inputs = 0;
 }
 
 #endif
@@ -0,0 +1,169 @@
+#ifndef _FREE_CELLS_H_
+#define _FREE_CELLS_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "occupancy.h"
+#include "rng.h"
+
+#include <glm/glm.hpp>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SPAWN_REGIONS 8
+#define INVALID_SLOT 0xffffffffu
+
+// Cells that food may spawn on, kept as a dense array plus a cell -> slot index so
+// insertion, removal and uniform sampling are all O(1). The dense array is partitioned
+// by spawn region: region r owns slots [region_start[r], region_start[r] + region_size[r])
+// and its free cells are packed at the front of that range.
+struct FreeCellSet {
+    u32 *cells;
+    u32 *slot;
+    u8 *region_of;
+    u32 cell_count;
+    u32 region_start[MAX_SPAWN_REGIONS];
+    u32 region_size[MAX_SPAWN_REGIONS];
+    u32 region_free[MAX_SPAWN_REGIONS];
+    u32 region_weight[MAX_SPAWN_REGIONS];
+    i32 region_count;
+};
+
+static void layout_spawn_regions(FreeCellSet *set) {
+    memset(set->region_size, 0, sizeof(set->region_size));
+
+    for (u32 cell = 0; cell < set->cell_count; cell++) {
+        set->region_size[set->region_of[cell]]++;
+    }
+
+    u32 start = 0;
+    for (i32 region = 0; region < set->region_count; region++) {
+        set->region_start[region] = start;
+        start += set->region_size[region];
+    }
+}
+
+void init_free_cells(FreeCellSet *set, u32 cell_count) {
+    set->cell_count = cell_count;
+    set->cells = (u32 *)malloc(cell_count * sizeof(u32));
+    set->slot = (u32 *)malloc(cell_count * sizeof(u32));
+    set->region_of = (u8 *)calloc(cell_count, sizeof(u8));
+    set->region_count = 1;
+    set->region_weight[0] = 1;
+    layout_spawn_regions(set);
+}
+
+void free_free_cells(FreeCellSet *set) {
+    free(set->cells);
+    free(set->slot);
+    free(set->region_of);
+    set->cells = NULL;
+    set->slot = NULL;
+    set->region_of = NULL;
+    set->cell_count = 0;
+}
+
+void set_spawn_weight(FreeCellSet *set, i32 region, u32 weight) {
+    set->region_weight[region] = weight;
+}
+
+static void free_cells_add(FreeCellSet *set, u32 cell) {
+    if (set->slot[cell] != INVALID_SLOT) return;
+
+    u32 region = set->region_of[cell];
+    u32 slot = set->region_start[region] + set->region_free[region]++;
+    set->cells[slot] = cell;
+    set->slot[cell] = slot;
+}
+
+static void free_cells_remove(FreeCellSet *set, u32 cell) {
+    u32 slot = set->slot[cell];
+    if (slot == INVALID_SLOT) return;
+
+    u32 region = set->region_of[cell];
+    u32 last_slot = set->region_start[region] + --set->region_free[region];
+    u32 last_cell = set->cells[last_slot];
+
+    set->cells[slot] = last_cell;
+    set->slot[last_cell] = slot;
+    set->slot[cell] = INVALID_SLOT;
+}
+
+static u32 free_cells_total(FreeCellSet *set) {
+    u32 total = 0;
+    for (i32 region = 0; region < set->region_count; region++) {
+        total += set->region_free[region];
+    }
+    return total;
+}
+
+void reset_free_cells(FreeCellSet *set, OccupancyGrid *map) {
+    memset(set->region_free, 0, sizeof(set->region_free));
+    memset(set->slot, 0xff, set->cell_count * sizeof(u32));
+
+    for (u32 cell = 0; cell < set->cell_count; cell++) {
+        if (!((map->words[cell >> 6] >> (cell & 63)) & 1)) free_cells_add(set, cell);
+    }
+}
+
+// Moves the cells inside [min, max] into a new spawn region. Food lands in a region with
+// probability proportional to its weight among regions that still have free cells. The set is
+// rebuilt from `map`, so this works mid-game, but cells the map shows free and the set leaves
+// out (food) come back in; add_spawn_region in game.h takes them out again.
+i32 add_free_cells_region(FreeCellSet *set, const Board *board, OccupancyGrid *map, glm::ivec2 min, glm::ivec2 max,
+                          u32 weight) {
+    if (set->region_count >= MAX_SPAWN_REGIONS) return -1;
+
+    i32 region = set->region_count++;
+    set->region_weight[region] = weight;
+
+    min = glm::clamp(min, glm::ivec2(0, 0), glm::ivec2(board->width - 1, board->height - 1));
+    max = glm::clamp(max, glm::ivec2(0, 0), glm::ivec2(board->width - 1, board->height - 1));
+
+    for (i32 y = min.y; y <= max.y; y++) {
+        for (i32 x = min.x; x <= max.x; x++) {
+            set->region_of[board_index(board, { x, y })] = (u8)region;
+        }
+    }
+
+    layout_spawn_regions(set);
+    reset_free_cells(set, map);
+    return region;
+}
+
+// Picks a free cell, or -1 when none are left. Region choice is a pass over at most
+// MAX_SPAWN_REGIONS weights, so sampling stays constant-time regardless of board size.
+static i32 free_cells_sample(FreeCellSet *set, Rng *rng) {
+    if (set->region_count == 1) {
+        return set->region_free[0] ? (i32)set->cells[rng_below(rng, set->region_free[0])] : -1;
+    }
+
+    u32 total_weight = 0;
+    for (i32 region = 0; region < set->region_count; region++) {
+        if (set->region_free[region]) total_weight += set->region_weight[region];
+    }
+
+    if (total_weight == 0) {
+        // Only zero-weight regions have room left, fall back to picking among them uniformly.
+        u32 total = free_cells_total(set);
+        if (total == 0) return -1;
+
+        u32 n = rng_below(rng, total);
+        for (i32 region = 0; region < set->region_count; region++) {
+            if (n < set->region_free[region]) return set->cells[set->region_start[region] + n];
+            n -= set->region_free[region];
+        }
+    }
+
+    u32 pick = rng_below(rng, total_weight);
+    i32 region = 0;
+    for (; region < set->region_count; region++) {
+        if (!set->region_free[region]) continue;
+        if (pick < set->region_weight[region]) break;
+        pick -= set->region_weight[region];
+    }
+
+    return set->cells[set->region_start[region] + rng_below(rng, set->region_free[region])];
+}
+
+#endif
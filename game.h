@@ -0,0 +1,259 @@
+#ifndef _GAME_H_
+#define _GAME_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "tail_ring.h"
+#include "occupancy.h"
+#include "free_cells.h"
+#include "rng.h"
+
+#include <glm/glm.hpp>
+#include <stdlib.h>
+#include <string.h>
+
+enum Direction {
+    DIRECTION_NONE,
+    DIRECTION_UP,
+    DIRECTION_RIGHT,
+    DIRECTION_DOWN,
+    DIRECTION_LEFT,
+};
+
+enum TickResult {
+    TICK_MOVED,
+    TICK_ATE,
+    TICK_DIED,
+    TICK_WON,
+};
+
+struct SnakeData {
+    TailRing tail;
+    glm::ivec2 velocity;
+    bool32 should_grow;
+};
+
+#define MAX_FOOD 16
+
+struct TurnsQueue {
+    i32 size;
+    i32 data[3];
+};
+
+struct GameState {
+    Board board;
+    SnakeData snake;
+    TurnsQueue turns_queue;
+    OccupancyGrid map;
+    FreeCellSet free_cells;
+    Rng rng;
+    bool32 paused;
+    bool32 is_over;
+    i32 cells_left;
+    i32 food_target;
+    i32 food_count;
+    glm::ivec2 food_pos[MAX_FOOD];
+};
+
+void push_queue(TurnsQueue *queue, i32 direction) {
+    if (queue->size < ARR_SIZE(queue->data)) {
+        queue->data[queue->size++] = direction;
+    }
+}
+
+static i32 pop_queue(TurnsQueue *queue) {
+    i32 result = DIRECTION_NONE;
+
+    if (queue->size > 0) {
+        result = queue->data[0];
+        for (size_t i = 1; i < queue->size; i++) {
+            queue->data[i - 1] = queue->data[i];
+        }
+        queue->size--;
+    }
+
+    return result;
+}
+
+static void push_new_head(TailRing *tail, OccupancyGrid *map, FreeCellSet *free_cells, glm::ivec2 pos, u32 cell) {
+    tail_push_front(tail, { pos });
+    map_set(map, cell, 1);
+    free_cells_remove(free_cells, cell);
+}
+
+static void pop_tail(TailRing *tail, OccupancyGrid *map, FreeCellSet *free_cells, u32 tail_tip_cell) {
+    tail_pop_back(tail);
+    map_set(map, tail_tip_cell, 0);
+    free_cells_add(free_cells, tail_tip_cell);
+}
+
+static glm::ivec2 direction_to_velocity(i32 direction) {
+    switch (direction) {
+        #define DIRECTION_TO_VELOCITY(dir, x, y) case dir: return {x, y}
+        DIRECTION_TO_VELOCITY(DIRECTION_UP, 0, -1);
+        DIRECTION_TO_VELOCITY(DIRECTION_RIGHT, 1, 0);
+        DIRECTION_TO_VELOCITY(DIRECTION_DOWN, 0, 1);
+        DIRECTION_TO_VELOCITY(DIRECTION_LEFT, -1, 0);
+    }
+    return {0, 0};
+}
+
+static i32 velocity_to_direction(glm::ivec2 velocity) {
+    if (velocity.y < 0) return DIRECTION_UP;
+    if (velocity.x > 0) return DIRECTION_RIGHT;
+    if (velocity.y > 0) return DIRECTION_DOWN;
+    if (velocity.x < 0) return DIRECTION_LEFT;
+    return DIRECTION_NONE;
+}
+
+static bool32 can_change_direction(glm::ivec2 old_velocity, glm::ivec2 new_velocity) {
+    glm::ivec2 sum = old_velocity + new_velocity;
+    return sum.x && sum.y;
+}
+
+// Food cells are taken out of the free set while they hold food, so two items never share a
+// cell. The head landing on one leaves it out; it comes back when the tail moves off it.
+static bool32 gen_random_food_pos(const Board *board, FreeCellSet *free_cells, Rng *rng, glm::ivec2 *food_pos) {
+    i32 cell = free_cells_sample(free_cells, rng);
+    if (cell < 0) return false;
+
+    free_cells_remove(free_cells, (u32)cell);
+    *food_pos = board_position(board, (u32)cell);
+    return true;
+}
+
+static void spawn_food(GameState *game) {
+    while (game->food_count < game->food_target &&
+           gen_random_food_pos(&game->board, &game->free_cells, &game->rng, &game->food_pos[game->food_count])) {
+        game->food_count++;
+    }
+}
+
+static i32 food_at(GameState *game, glm::ivec2 pos) {
+    for (i32 i = 0; i < game->food_count; i++) {
+        if (game->food_pos[i] == pos) return i;
+    }
+    return -1;
+}
+
+static void turn_snake(SnakeData *snake, TurnsQueue *queue) {
+    i32 new_dir = pop_queue(queue);
+
+    if (new_dir) {
+        glm::ivec2 new_velocity = direction_to_velocity(new_dir);
+
+        if (can_change_direction(snake->velocity, new_velocity)) {
+            snake->velocity = new_velocity;
+        }
+    }
+}
+
+void init_game(GameState *game, i32 width, i32 height) {
+    game->board = make_board(width, height);
+    init_tail(&game->snake.tail, game->board.cell_count);
+    init_map(&game->map, game->board.cell_count);
+    init_free_cells(&game->free_cells, game->board.cell_count);
+    game->food_target = 1;
+    rng_seed(&game->rng, 0);
+}
+
+// The generator carries over restarts, so a seeded game and everything after it replays exactly.
+void seed_game(GameState *game, u64 seed) {
+    rng_seed(&game->rng, seed);
+}
+
+void set_food_count(GameState *game, i32 count) {
+    game->food_target = count < 1 ? 1 : (count > MAX_FOOD ? MAX_FOOD : count);
+}
+
+// See add_free_cells_region. Food already on the board stays where it is.
+i32 add_spawn_region(GameState *game, glm::ivec2 min, glm::ivec2 max, u32 weight) {
+    i32 region = add_free_cells_region(&game->free_cells, &game->board, &game->map, min, max, weight);
+    if (region < 0) return region;
+
+    for (i32 i = 0; i < game->food_count; i++) {
+        free_cells_remove(&game->free_cells, board_index(&game->board, game->food_pos[i]));
+    }
+    return region;
+}
+
+void free_game(GameState *game) {
+    free_tail(&game->snake.tail);
+    free_map(&game->map);
+    free_free_cells(&game->free_cells);
+}
+
+void restart_game(GameState *game) {
+    const glm::ivec2 initial_positions[] = {
+        {3, 1}, {2, 1}, {1, 1}
+    };
+
+    game->is_over = false;
+    game->paused = false;
+    game->turns_queue.size = 0;
+    game->cells_left = game->board.cell_count - ARR_SIZE(initial_positions);
+    tail_clear(&game->snake.tail);
+    map_clear(&game->map);
+
+    for (i32 i = 0; i < ARR_SIZE(initial_positions); i++) {
+        tail_push_back(&game->snake.tail, { initial_positions[i] });
+        map_set(&game->map, board_index(&game->board, initial_positions[i]), 1);
+    }
+
+    game->snake.should_grow = false;
+    game->snake.velocity = { 1, 0 };
+
+    reset_free_cells(&game->free_cells, &game->map);
+    game->food_count = 0;
+    spawn_food(game);
+}
+
+template <typename Geometry>
+static TickResult update_snake(GameState *game, Geometry geometry) {
+    TickResult result = TICK_MOVED;
+    SnakeData *snake = &game->snake;
+    TurnsQueue *queue = &game->turns_queue;
+    turn_snake(snake, queue);
+
+    if (snake->should_grow) {
+        snake->should_grow = false;
+
+        if (--game->cells_left <= 0) {
+            game->paused = true;
+            game->is_over = true;
+            result = TICK_WON;
+        }
+    } else {
+        pop_tail(&snake->tail, &game->map, &game->free_cells, geometry.index(tail_back(&snake->tail)->pos));
+    }
+
+    glm::ivec2 new_head_pos = geometry.step(tail_front(&snake->tail)->pos, snake->velocity);
+    u32 new_head_cell = geometry.index(new_head_pos);
+
+    if (!map_at(&game->map, new_head_cell)) {
+        push_new_head(&snake->tail, &game->map, &game->free_cells, new_head_pos, new_head_cell);
+    } else {
+        restart_game(game);
+        return TICK_DIED;
+    }
+
+    i32 eaten = game->is_over ? -1 : food_at(game, new_head_pos);
+    if (eaten >= 0) {
+        game->food_pos[eaten] = game->food_pos[--game->food_count];
+        spawn_food(game);
+        snake->should_grow = true;
+        result = TICK_ATE;
+    }
+
+    return result;
+}
+
+TickResult update_snake(GameState *game) {
+    #define UPDATE_HOT_BOARD(W, H) \
+        if (game->board.width == W && game->board.height == H) return update_snake(game, FixedGeometry<W, H>());
+    HOT_BOARD_SIZES(UPDATE_HOT_BOARD)
+
+    return update_snake(game, RuntimeGeometry{ &game->board });
+}
+
+#endif
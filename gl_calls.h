@@ -0,0 +1,61 @@
+#ifndef _GL_CALLS_H_
+#define _GL_CALLS_H_
+
+#include "typedefs.h"
+
+#include <glad/glad.h>
+
+// Counts GL API calls. glad reaches every function through a pointer, so counting swaps the
+// pointers of the functions listed in GL_COUNTED_CALLS for wrappers that bump gl_call_count and
+// forward to the driver. Call count_gl_calls() after loading GL; until then nothing is counted
+// and calls cost nothing extra. Functions missing from the list aren't counted, so anything new
+// the renderer calls belongs in it.
+
+#define GL_COUNTED_CALLS(X) \
+    X(glActiveTexture) X(glAttachShader) X(glBeginQuery) X(glBindBuffer) X(glBindBufferBase) \
+    X(glBindBufferRange) X(glBindFramebuffer) X(glBindRenderbuffer) X(glBindTexture) \
+    X(glBindVertexArray) X(glBufferData) X(glBufferSubData) X(glClear) X(glClearColor) \
+    X(glClientWaitSync) X(glCompileShader) X(glCopyBufferSubData) X(glCreateProgram) \
+    X(glCreateShader) X(glDeleteBuffers) X(glDeleteProgram) X(glDeleteQueries) X(glDeleteShader) \
+    X(glDeleteSync) X(glDeleteTextures) X(glDeleteVertexArrays) X(glDisable) X(glDrawArrays) \
+    X(glDrawArraysInstanced) X(glDrawElements) X(glDrawElementsInstanced) X(glEnable) \
+    X(glEnableVertexAttribArray) X(glEndQuery) X(glFenceSync) X(glFinish) \
+    X(glFramebufferRenderbuffer) X(glGenBuffers) X(glGenFramebuffers) X(glGenQueries) \
+    X(glGenRenderbuffers) X(glGenTextures) X(glGenVertexArrays) X(glGetActiveUniform) \
+    X(glGetActiveUniformBlockiv) X(glGetIntegerv) X(glGetProgramInfoLog) X(glGetProgramiv) \
+    X(glGetQueryObjectui64v) X(glGetShaderInfoLog) X(glGetShaderiv) X(glGetString) X(glGetStringi) \
+    X(glGetUniformBlockIndex) X(glGetUniformLocation) X(glLinkProgram) X(glMapBufferRange) \
+    X(glPixelStorei) X(glReadPixels) X(glRenderbufferStorage) X(glScissor) X(glShaderSource) \
+    X(glTexBuffer) X(glTexImage2D) X(glTexParameteri) X(glTexSubImage2D) X(glUniform1f) \
+    X(glUniform1i) X(glUniform2f) X(glUniform2i) X(glUniform3f) X(glUniformBlockBinding) \
+    X(glUniformMatrix4fv) X(glUnmapBuffer) X(glUseProgram) X(glVertexAttribDivisor) \
+    X(glVertexAttribPointer) X(glViewport)
+
+static u64 gl_call_count;
+
+template <typename Function, Function *slot> struct CountedGlCall;
+
+template <typename Result, typename... Args, Result (APIENTRYP *slot)(Args...)>
+struct CountedGlCall<Result (APIENTRYP)(Args...), slot> {
+    static inline Result (APIENTRYP driver)(Args...);
+
+    static Result APIENTRY call(Args... args) {
+        gl_call_count++;
+        return driver(args...);
+    }
+
+    static void install() {
+        if (!*slot || *slot == call) return;
+        driver = *slot;
+        *slot = call;
+    }
+};
+
+// Safe to call more than once.
+void count_gl_calls() {
+    #define COUNT_GL_CALL(name) CountedGlCall<decltype(glad_##name), &glad_##name>::install();
+    GL_COUNTED_CALLS(COUNT_GL_CALL)
+    #undef COUNT_GL_CALL
+}
+
+#endif
@@ -1,22 +1,23 @@
 #ifndef _GRID_H_
 #define _GRID_H_
 
-#include "typedefs.h"
+#include "object.h"
+#include "board.h"
 #include "util.h"
 
 #include <glm/glm.hpp>
 
-ObjectData configure_grid(glm::ivec2 window_size) {
+ObjectData configure_grid(glm::ivec2 window_size, Board board) {
     ObjectData grid;
 
-    float cell_width = (float)window_size.x / CELL_COUNT;
-    float cell_height = (float)window_size.y / CELL_COUNT;
+    float cell_width = (float)window_size.x / board.width;
+    float cell_height = (float)window_size.y / board.height;
 
     /*
-    const i32 grid_vertices_count = (CELL_COUNT - 1) * 4 + 8;
+    const i32 grid_vertices_count = (board.width - 1) * 4 + 8;
     Vertex grid_vertices[grid_vertices_count];
 
-    for (size_t i = 0; i < CELL_COUNT - 1; i++) {
+    for (size_t i = 0; i < board.width - 1; i++) {
         float x = cell_width * (i + 1) / (float)window_size.x * 2 - 1;
         float y = cell_height * (i + 1) / (float)window_size.y * 2 - 1;
 
@@ -70,21 +71,7 @@ ObjectData configure_grid(glm::ivec2 window_size) {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    u32 grid_shader = glCreateProgram();
-    u32 grid_vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    u32 grid_fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-
-    compile_shader_file(grid_vertex_shader, "./shaders/grid.vert");
-    compile_shader_file(grid_fragment_shader, "./shaders/grid.frag");
-
-    glAttachShader(grid_shader, grid_vertex_shader);
-    glAttachShader(grid_shader, grid_fragment_shader);
-    glLinkProgram(grid_shader);
-
-    grid.shader = grid_shader;
-
-    glDeleteShader(grid_vertex_shader);
-    glDeleteShader(grid_fragment_shader);
+    grid.shader = load_shader_program("./shaders/grid.vert", "./shaders/grid.frag");
 
     return grid;
 }
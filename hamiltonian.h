@@ -0,0 +1,147 @@
+#ifndef _HAMILTONIAN_H_
+#define _HAMILTONIAN_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "game.h"
+
+#include <mutex>
+#include <stdlib.h>
+
+// Hamiltonian-cycle solver. Following a cycle through every cell can never collide, and it
+// stays safe with shortcuts as long as the body occupies cycle positions in order from tail
+// to head: then every cell on the cycle strictly between head and tail is empty, so the head
+// may jump to any neighbour in that stretch. That holds from restart_game onwards, since the
+// initial snake lies along the cycle.
+//
+// The cycle goes down column 0, then zig-zags through columns 1..W-1 from the bottom row to
+// the top one, and closes through (1, 0) or, for odd heights, through the wrap from (W-1, 0).
+struct HamiltonianCycle {
+    i32 width;
+    i32 height;
+    u32 cell_count;
+    u32 *order;
+    u32 *cells;
+    HamiltonianCycle *next;
+};
+
+static void build_cycle(HamiltonianCycle *cycle, const Board *board) {
+    cycle->width = board->width;
+    cycle->height = board->height;
+    cycle->cell_count = board->cell_count;
+    cycle->order = (u32 *)malloc(board->cell_count * sizeof(u32));
+    cycle->cells = (u32 *)malloc(board->cell_count * sizeof(u32));
+
+    u32 count = 0;
+    for (i32 y = 0; y < board->height; y++) {
+        cycle->cells[count++] = board_index(board, { 0, y });
+    }
+    for (i32 row = 0; row < board->height; row++) {
+        i32 y = board->height - 1 - row;
+        for (i32 i = 1; i < board->width; i++) {
+            i32 x = row % 2 == 0 ? i : board->width - i;
+            cycle->cells[count++] = board_index(board, { x, y });
+        }
+    }
+
+    // Orient the cycle so the snake from restart_game, which runs (1, 1) -> (3, 1), follows it.
+    u32 tail_cell = board_index(board, { 1, 1 });
+    u32 next_cell = board_index(board, { 2, 1 });
+    for (u32 i = 0; i < count; i++) {
+        if (cycle->cells[i] != tail_cell) continue;
+        if (cycle->cells[(i + 1) % count] != next_cell) {
+            for (u32 a = 0, b = count - 1; a < b; a++, b--) {
+                u32 swap = cycle->cells[a];
+                cycle->cells[a] = cycle->cells[b];
+                cycle->cells[b] = swap;
+            }
+        }
+        break;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        cycle->order[cycle->cells[i]] = i;
+    }
+}
+
+// Cycles are built once per board size and shared read-only, including across threads. They
+// live until the process exits, so a pointer from here never dangles.
+const HamiltonianCycle *cycle_for_board(const Board *board) {
+    static HamiltonianCycle *cache = NULL;
+    static std::mutex cache_mutex;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (HamiltonianCycle *cycle = cache; cycle; cycle = cycle->next) {
+        if (cycle->width == board->width && cycle->height == board->height) return cycle;
+    }
+
+    HamiltonianCycle *cycle = (HamiltonianCycle *)malloc(sizeof(HamiltonianCycle));
+    build_cycle(cycle, board);
+    cycle->next = cache;
+    cache = cycle;
+    return cycle;
+}
+
+// Steps along the cycle from `from` to `to`.
+static u32 cycle_distance(const HamiltonianCycle *cycle, u32 from, u32 to) {
+    u32 a = cycle->order[from], b = cycle->order[to];
+    return b >= a ? b - a : b + cycle->cell_count - a;
+}
+
+// The neighbour that gets furthest along the cycle without passing the nearest food or
+// reaching the tail. Falls back to the next cell on the cycle.
+i32 hamiltonian_direction(const HamiltonianCycle *cycle, GameState *game) {
+    const Board *board = &game->board;
+    u32 head = board_index(board, tail_front(&game->snake.tail)->pos);
+    u32 tail = board_index(board, tail_back(&game->snake.tail)->pos);
+    u32 to_tail = cycle_distance(cycle, head, tail);
+    if (to_tail == 0) to_tail = cycle->cell_count;
+
+    u32 to_food = to_tail;
+    for (i32 i = 0; i < game->food_count; i++) {
+        u32 distance = cycle_distance(cycle, head, board_index(board, game->food_pos[i]));
+        if (distance > 0 && distance < to_food) to_food = distance;
+    }
+
+    u32 neighbors[4];
+    board_neighbors(board, head, neighbors);
+
+    // Every skipped cell is a hole behind the head that only comes back once the tail passes
+    // it, and food landing there while the head closes in on the tail can still kill a
+    // growing snake. So only jump while the stretch ahead stays longer than the one behind.
+    u32 behind = cycle->cell_count - to_tail;
+
+    i32 best_direction = DIRECTION_NONE;
+    u32 best_distance = 0;
+    for (i32 i = 0; i < 4; i++) {
+        u32 distance = cycle_distance(cycle, head, neighbors[i]);
+        if (distance == 0 || distance >= to_tail || distance > to_food) continue;
+        if (distance > 1 && to_tail - distance <= behind + distance) continue;
+        if (distance > best_distance) {
+            best_distance = distance;
+            best_direction = DIRECTION_UP + i;
+        }
+    }
+
+    if (best_direction == DIRECTION_NONE) {
+        u32 next = cycle->cells[(cycle->order[head] + 1) % cycle->cell_count];
+        for (i32 i = 0; i < 4; i++) {
+            if (neighbors[i] == next) best_direction = DIRECTION_UP + i;
+        }
+    }
+
+    return best_direction;
+}
+
+// Queues the solver's turn; returns it, or DIRECTION_NONE when the snake keeps going straight.
+i32 hamiltonian_steer(const HamiltonianCycle *cycle, GameState *game) {
+    if (game->turns_queue.size > 0) return DIRECTION_NONE;
+
+    i32 direction = hamiltonian_direction(cycle, game);
+    if (!direction || direction == velocity_to_direction(game->snake.velocity)) return DIRECTION_NONE;
+
+    push_queue(&game->turns_queue, direction);
+    return direction;
+}
+
+#endif
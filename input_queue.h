@@ -0,0 +1,92 @@
+#ifndef _INPUT_QUEUE_H_
+#define _INPUT_QUEUE_H_
+
+#include "typedefs.h"
+
+#include <stdlib.h>
+
+// Lock-free single-producer/single-consumer ring of timestamped input events, so key capture
+// and the simulation can run on different threads. One thread may push, one other thread may
+// peek and pop.
+//
+// Overflow policy: a push onto a full queue is rejected. What is already queued is kept,
+// push_input returns false and the event is counted in `dropped`, so the caller can tell the
+// player or log it. Older intents are never overwritten behind the consumer's back.
+
+#define INPUT_QUEUE_DEFAULT_DEPTH 16
+#define INPUT_QUEUE_CACHE_LINE 64
+
+struct InputEvent {
+    // A direction or a ReplayEvent.
+    i32 event;
+    // platform_time_ns() when the event was captured.
+    u64 time_ns;
+};
+
+struct InputQueue {
+    InputEvent *events;
+    u32 mask;
+
+    // Each side owns one index and keeps a stale copy of the other's, refreshed only when the
+    // ring looks full or empty, so the shared lines are touched once per batch, not per event.
+    alignas(INPUT_QUEUE_CACHE_LINE) u64 write;
+    u64 cached_read;
+    u64 dropped;
+    alignas(INPUT_QUEUE_CACHE_LINE) u64 read;
+    u64 cached_write;
+};
+
+// `depth` is rounded up to a power of two.
+void init_input_queue(InputQueue *queue, u32 depth) {
+    u32 capacity = 1;
+    while (capacity < depth) capacity <<= 1;
+
+    queue->events = (InputEvent *)calloc(capacity, sizeof(InputEvent));
+    queue->mask = capacity - 1;
+    queue->write = queue->cached_read = queue->dropped = 0;
+    queue->read = queue->cached_write = 0;
+}
+
+void free_input_queue(InputQueue *queue) {
+    free(queue->events);
+    queue->events = NULL;
+}
+
+// Producer side.
+bool32 push_input(InputQueue *queue, i32 event, u64 time_ns) {
+    u64 write = queue->write;
+    if (write - queue->cached_read > queue->mask) {
+        queue->cached_read = __atomic_load_n(&queue->read, __ATOMIC_ACQUIRE);
+        if (write - queue->cached_read > queue->mask) {
+            __atomic_store_n(&queue->dropped, queue->dropped + 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    }
+
+    queue->events[write & queue->mask] = { event, time_ns };
+    __atomic_store_n(&queue->write, write + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Consumer side. The event stays queued until pop_input, which may only follow a successful
+// peek_input.
+bool32 peek_input(InputQueue *queue, InputEvent *event) {
+    u64 read = queue->read;
+    if (read == queue->cached_write) {
+        queue->cached_write = __atomic_load_n(&queue->write, __ATOMIC_ACQUIRE);
+        if (read == queue->cached_write) return false;
+    }
+
+    *event = queue->events[read & queue->mask];
+    return true;
+}
+
+void pop_input(InputQueue *queue) {
+    __atomic_store_n(&queue->read, queue->read + 1, __ATOMIC_RELEASE);
+}
+
+u64 input_dropped(InputQueue *queue) {
+    return __atomic_load_n(&queue->dropped, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef _INSTANCE_BATCH_H_
+#define _INSTANCE_BATCH_H_
+
+#include "typedefs.h"
+#include "object.h"
+#include "cell.h"
+#include "bridge.h"
+#include "stream_buffer.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <stdlib.h>
+
+// Everything drawn in a frame, collected on the CPU and submitted as one instanced draw for
+// the cells and one for the bridges, their instances streamed through a StreamBuffer.
+
+#define INSTANCE_BATCH_INITIAL_CAPACITY 256
+
+struct InstanceBatch {
+    CellInstance *cells;
+    u32 cell_count;
+    u32 cell_capacity;
+    BridgeInstance *bridges;
+    u32 bridge_count;
+    u32 bridge_capacity;
+};
+
+void init_instance_batch(InstanceBatch *batch) {
+    batch->cell_capacity = batch->bridge_capacity = INSTANCE_BATCH_INITIAL_CAPACITY;
+    batch->cells = (CellInstance *)malloc(batch->cell_capacity * sizeof(CellInstance));
+    batch->bridges = (BridgeInstance *)malloc(batch->bridge_capacity * sizeof(BridgeInstance));
+    batch->cell_count = batch->bridge_count = 0;
+}
+
+void free_instance_batch(InstanceBatch *batch) {
+    free(batch->cells);
+    free(batch->bridges);
+    batch->cells = NULL;
+    batch->bridges = NULL;
+}
+
+void clear_instance_batch(InstanceBatch *batch) {
+    batch->cell_count = batch->bridge_count = 0;
+}
+
+static void push_cell(InstanceBatch *batch, glm::vec2 pos, glm::vec3 color) {
+    if (batch->cell_count == batch->cell_capacity) {
+        batch->cell_capacity *= 2;
+        batch->cells = (CellInstance *)realloc(batch->cells, batch->cell_capacity * sizeof(CellInstance));
+    }
+    batch->cells[batch->cell_count++] = { pos, color };
+}
+
+static void push_bridge(InstanceBatch *batch, glm::vec2 cell_position, glm::ivec2 direction) {
+    if (batch->bridge_count == batch->bridge_capacity) {
+        batch->bridge_capacity *= 2;
+        batch->bridges = (BridgeInstance *)realloc(batch->bridges, batch->bridge_capacity * sizeof(BridgeInstance));
+    }
+    batch->bridges[batch->bridge_count++] = { cell_position, glm::vec2(direction) };
+}
+
+// Room the batch takes in a stream buffer, for begin_stream_frame.
+u64 instance_batch_bytes(const InstanceBatch *batch, const StreamBuffer *stream) {
+    return stream_space(stream, batch->cell_count * sizeof(CellInstance)) +
+           stream_space(stream, batch->bridge_count * sizeof(BridgeInstance));
+}
+
+static void draw_instances(ObjectData *object, u32 count) {
+    glUseProgram(object->shader.id);
+    glDrawArraysInstanced(object->primitive, 0, object->vertex_count, (GLsizei)count);
+}
+
+// Writes the instances into the frame's stream region, so nothing here waits on draws still
+// reading earlier frames.
+void render_instance_batch(InstanceBatch *batch, StreamBuffer *stream, ObjectData *cell, ObjectData *bridge) {
+    i64 offset = batch->cell_count ? stream_write(stream, batch->cells, batch->cell_count * sizeof(CellInstance)) : -1;
+    if (offset >= 0) {
+        point_cell_instances(cell, stream->buffer, offset);
+        draw_instances(cell, batch->cell_count);
+    }
+
+    offset = batch->bridge_count ? stream_write(stream, batch->bridges, batch->bridge_count * sizeof(BridgeInstance)) : -1;
+    if (offset >= 0) {
+        point_bridge_instances(bridge, stream->buffer, offset);
+        draw_instances(bridge, batch->bridge_count);
+    }
+
+    // The array buffer binding isn't part of a VAO's state.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+#endif
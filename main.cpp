@@ -1,6 +1,5 @@
-#define CELL_COUNT 15
 #define GAP 12.0f
-#define ARR_SIZE(arr) (sizeof(arr) / sizeof(*arr))
+#define QUICKSAVE_PATH "snake.save"
 
 #include "typedefs.h"
 #include "platform.h"
@@ -9,90 +8,488 @@
 #include "bridge.h"
 #include "grid.h"
 #include "framerate.h"
+#include "frame_pacer.h"
 #include "snake.h"
+#include "board_pass.h"
+#include "replay.h"
+#include "autopilot.h"
+#include "hamiltonian.h"
+#include "mcts.h"
+#include "arena.h"
+#include "input_queue.h"
+#include "profiler.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <time.h>
 
+enum PilotMode {
+    PILOT_MANUAL,
+    PILOT_AUTOPILOT,
+    PILOT_SOLVER,
+    PILOT_MCTS,
+};
+
+struct ClientState {
+    GameState game;
+    Autopilot autopilot;
+    const HamiltonianCycle *cycle;
+    MctsPool *mcts;
+    Arena *arena;
+    Camera camera;
+    InputQueue input;
+    SnakeMotion motion;
+    u32 tick_rate;
+    FrameStats *frame_stats;
+    Profiler *profiler;
+    ReplayRecorder *recorder;
+    bool32 is_replaying;
+    i32 pilot;
+};
+
+static void client_event(ClientState *client, i32 event) {
+    if (client->recorder) record_event(client->recorder, event);
+}
+
+static void client_restart(ClientState *client) {
+    restart_game(&client->game);
+    client->motion.is_valid = false;
+    client_event(client, REPLAY_EVENT_RESTART);
+    if (client->pilot == PILOT_AUTOPILOT) reset_autopilot(&client->autopilot, &client->game);
+}
+
+// Turns, growing and restarts reach the game through the input queue and are applied before
+// a tick, at most one turn per tick as the game reads them. Turns left over while the game
+// can't move are discarded, as the arrow keys are ignored then. A dropped event is reported
+// rather than lost silently.
+static void client_input(ClientState *client, i32 event) {
+    if (!push_input(&client->input, event, platform_time_ns())) {
+        fprintf(stderr, "input queue full, dropped event %d (%llu dropped)\n", event,
+                (unsigned long long)input_dropped(&client->input));
+    }
+}
+
+// Every event applied adds its wait, from capture to the tick it's applied for, to the input
+// latency shown in the title.
+static void apply_input(ClientState *client, TurnsQueue *turns_queue, bool32 can_turn) {
+    bool32 has_turned = false;
+    InputEvent input;
+    while (peek_input(&client->input, &input)) {
+        if (input.event == REPLAY_EVENT_GROW) {
+            client->game.snake.should_grow = true;
+            client_event(client, REPLAY_EVENT_GROW);
+        } else if (input.event == REPLAY_EVENT_RESTART) {
+            client_restart(client);
+        } else if (can_turn) {
+            if (has_turned) break;
+            has_turned = true;
+            client->pilot = PILOT_MANUAL;
+            push_queue(turns_queue, input.event);
+            client_event(client, input.event);
+        }
+        bool32 is_applied = can_turn || input.event == REPLAY_EVENT_GROW || input.event == REPLAY_EVENT_RESTART;
+        if (is_applied) add_input_latency(client->frame_stats, platform_time_ns() - input.time_ns);
+        pop_input(&client->input);
+    }
+}
+
+// One simulation step. Runs at the tick rate, however often frames are drawn.
+static void client_tick(ClientState *client, Replay *replay, ReplayCursor *cursor) {
+    GameState *game = &client->game;
+
+    if (client->arena) {
+        apply_input(client, &client->arena->snakes[0].turns_queue, true);
+        for (i32 i = 1; i < client->arena->snake_count; i++) {
+            arena_steer_ai(client->arena, i);
+        }
+        arena_tick(client->arena);
+        return;
+    }
+
+    TickResult result = TICK_MOVED;
+    if (client->is_replaying) {
+        begin_snake_motion(&client->motion, &game->snake.tail);
+        if (!step_replay(replay, game, cursor, &result)) {
+            game->paused = true;
+            return;
+        }
+    } else {
+        apply_input(client, &game->turns_queue, true);
+
+        i32 direction = DIRECTION_NONE;
+        if (client->pilot == PILOT_AUTOPILOT) direction = autopilot_steer(&client->autopilot, game);
+        if (client->pilot == PILOT_SOLVER) direction = hamiltonian_steer(client->cycle, game);
+        if (client->pilot == PILOT_MCTS) direction = mcts_steer(client->mcts, game);
+        if (client->pilot != PILOT_MCTS && client->mcts) mcts_cancel(client->mcts);
+        if (direction) client_event(client, direction);
+
+        begin_snake_motion(&client->motion, &game->snake.tail);
+        result = update_snake(game);
+        if (client->recorder) record_tick(client->recorder, game);
+        if (client->pilot == PILOT_AUTOPILOT) autopilot_tick(&client->autopilot, game, result);
+        // The next turn is searched for while the frames up to the next tick are drawn.
+        if (client->pilot == PILOT_MCTS) mcts_begin(client->mcts, game, mcts_tick_budget(client->tick_rate));
+    }
+    end_snake_motion(&client->motion, &game->board, &game->snake.tail, result);
+}
+
+// Pressing a pilot's key again hands control back to the keyboard. The solver relies on the
+// body lying along its cycle, so it starts from a fresh game. The cycle and the MCTS pool are
+// only built once their pilot is first picked.
+static void toggle_pilot(ClientState *client, i32 pilot) {
+    if (client->is_replaying) return;
+
+    client->pilot = client->pilot == pilot ? PILOT_MANUAL : pilot;
+    if (client->pilot == PILOT_AUTOPILOT) reset_autopilot(&client->autopilot, &client->game);
+    if (client->pilot == PILOT_SOLVER) {
+        if (!client->cycle) client->cycle = cycle_for_board(&client->game.board);
+        client_restart(client);
+    }
+
+    // One core is left to the render loop, which keeps drawing while the search runs.
+    if (client->pilot == PILOT_MCTS && !client->mcts) {
+        client->mcts = new MctsPool();
+        init_mcts(client->mcts, &client->game.board, (i32)std::thread::hardware_concurrency() - 1, (u64)time(0));
+    }
+    if (client->pilot == PILOT_MCTS) mcts_begin(client->mcts, &client->game, mcts_tick_budget(client->tick_rate));
+}
+
 void key_callback(GLFWwindow *window, i32 key, i32 scancode, i32 action, i32 mods) {
     if (action == GLFW_PRESS) {
-        GameState *game = (GameState *)glfwGetWindowUserPointer(window);
+        ClientState *client = (ClientState *)glfwGetWindowUserPointer(window);
+        GameState *game = &client->game;
+
+        const Board *board = client->arena ? &client->arena->board : &game->board;
+        if (key == GLFW_KEY_EQUAL) camera_zoom(&client->camera, board, 1);
+        if (key == GLFW_KEY_MINUS) camera_zoom(&client->camera, board, -1);
+        if (key == GLFW_KEY_F3) {
+            set_profiler_enabled(client->profiler, !client->profiler->is_enabled);
+            client->profiler->shows_overlay = client->profiler->is_enabled;
+        }
+
+        // Arena mode only takes pausing, quitting, zooming and steering snake 0.
+        if (client->arena) {
+            if (key == GLFW_KEY_P) game->paused = !game->paused;
+            if (key == GLFW_KEY_ESCAPE) glfwSetWindowShouldClose(window, GL_TRUE);
+            if (!game->paused && key_to_direction(key)) client_input(client, key_to_direction(key));
+            return;
+        }
 
         #define KEY_ACTION(BUTTON, ACTION) case GLFW_KEY_##BUTTON: ACTION; break
         switch (key) {
             KEY_ACTION(P, game->paused = !game->paused);
-            KEY_ACTION(W, game->snake.should_grow = true);
-            KEY_ACTION(R, restart_game(game));
+            KEY_ACTION(A, toggle_pilot(client, PILOT_AUTOPILOT));
+            KEY_ACTION(H, toggle_pilot(client, PILOT_SOLVER));
+            KEY_ACTION(M, toggle_pilot(client, PILOT_MCTS));
             KEY_ACTION(ESCAPE, glfwSetWindowShouldClose(window, GL_TRUE));
 
+            case GLFW_KEY_W: {
+                if (!client->is_replaying) client_input(client, REPLAY_EVENT_GROW);
+            } break;
+
+            case GLFW_KEY_R: {
+                if (!client->is_replaying) client_input(client, REPLAY_EVENT_RESTART);
+            } break;
+
+            case GLFW_KEY_F5: {
+                if (!save_game_file(game, QUICKSAVE_PATH)) fprintf(stderr, "can't write %s\n", QUICKSAVE_PATH);
+            } break;
+
+            // Loading would break a recording, whose inputs only make sense from its own states.
+            case GLFW_KEY_F9: {
+                if (client->recorder || client->is_replaying) break;
+                if (!load_game_file(game, QUICKSAVE_PATH)) {
+                    fprintf(stderr, "can't load %s\n", QUICKSAVE_PATH);
+                    restart_game(game);
+                }
+                client->motion.is_valid = false;
+                if (client->pilot == PILOT_AUTOPILOT) reset_autopilot(&client->autopilot, game);
+            } break;
+
             case GLFW_KEY_UP:
             case GLFW_KEY_RIGHT:
             case GLFW_KEY_DOWN:
             case GLFW_KEY_LEFT: {
-                if (!game->paused) push_queue(&game->turns_queue, key);
+                if (game->paused || client->is_replaying) break;
+                client_input(client, key_to_direction(key));
             } break;
         }
     }
 }
 
-i32 main() {
-    srand(time(0));
+i32 main(i32 argc, char **argv) {
+    i32 board_width = 15;
+    i32 board_height = 15;
+    u64 seed = (u64)time(0);
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    u64 replay_start = 0;
+    i32 arena_snakes = 0;
+    bool32 has_board_size = false;
+    u32 tick_rate = 10;
+    // 0 follows the display's refresh rate.
+    u32 frame_rate = 0;
+    const char *profile_path = NULL;
+    bool32 uses_board_pass = false;
+
+    for (i32 i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-b") && i + 1 < argc && parse_board_size(argv[i + 1], &board_width, &board_height)) {
+            has_board_size = true;
+            i++;
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+            replay_start = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            arena_snakes = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            tick_rate = (u32)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc && atoi(argv[i + 1]) >= 0) {
+            frame_rate = (u32)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-P") && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (!strcmp(argv[i], "-B")) {
+            uses_board_pass = true;
+        } else {
+            fprintf(stderr, "usage: %s [-b WIDTHxHEIGHT] [-s seed] [-r record.replay] [-p play.replay [-k tick]] [-m snakes] "
+                    "[-t ticks/s] [-f frames/s] [-P profile.csv] [-B]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Replay replay = {};
+    if (replay_path) {
+        if (!open_replay(&replay, replay_path)) {
+            fprintf(stderr, "can't open replay %s\n", replay_path);
+            return 1;
+        }
+        board_width = replay.header.width;
+        board_height = replay.header.height;
+        seed = replay.header.seed;
+    }
+
+    if (arena_snakes > 0 && (record_path || replay_path)) {
+        fprintf(stderr, "-m can't be combined with -r or -p\n");
+        return 1;
+    }
+    if (arena_snakes > 0 && !has_board_size) {
+        board_width = board_height = glm::clamp((i32)ceil(sqrt((double)arena_snakes * ARENA_CELLS_PER_SNAKE)), 15, BOARD_MAX_SIDE);
+    }
+
+    printf("seed: %llu\n", (unsigned long long)seed);
     glfwInit();
 
     const bool32 is_fullscreen = true;
     glm::ivec2 window_size = { 800, 800 };
     GLFWmonitor *monitor = NULL;
 
-    i32 dim_diff = 0;
     if (is_fullscreen) {
         monitor = glfwGetPrimaryMonitor();
         const GLFWvidmode *mode = glfwGetVideoMode(monitor);
         window_size = { mode->width, mode->height };
-        dim_diff = window_size.x - window_size.y;
     }
 
+    ClientState client = {};
+    GameState &game = client.game;
+    init_input_queue(&client.input, INPUT_QUEUE_DEFAULT_DEPTH);
+    client.tick_rate = tick_rate;
+    init_game(&game, board_width, board_height);
+    seed_game(&game, seed);
+    init_autopilot(&client.autopilot, &game.board);
+
+    Arena arena = {};
+    if (arena_snakes > 0) {
+        init_arena(&arena, board_width, board_height, arena_snakes, arena_snakes * ARENA_FOOD_PER_SNAKE, seed);
+        client.arena = &arena;
+    }
+
+    const Board *shown_board = client.arena ? &arena.board : &game.board;
+    client.camera = make_camera(shown_board);
+    glm::vec2 cell_size = glm::vec2(CAMERA_CELL_SIZE, CAMERA_CELL_SIZE);
+
+    BodyIndex body_index = {};
+    init_body_index(&body_index, game.board.cell_count);
+    InstanceBatch batch = {};
+    init_instance_batch(&batch);
+
     GLFWwindow *window = glfwCreateWindow(window_size.x, window_size.y, "OpenGL Snake", monitor, NULL);
     glfwMakeContextCurrent(window);
 
     gladLoadGL();
-    glViewport(dim_diff / 2, 0, window_size.y, window_size.y);
+    glfwSwapInterval(frame_rate ? 0 : 1);
     glfwSetKeyCallback(window, key_callback);
 
-    ObjectData cell = configure_cell(window_size);
-    ObjectData bridge = configure_bridge(window_size);
-    ObjectData grid = configure_grid(window_size);
+    ObjectData cell = configure_cell();
+    ObjectData bridge = configure_bridge();
+    FrameData frame_data = make_frame_data(cell_size, GAP);
+    StreamBuffer stream;
+    init_stream_buffer(&stream, (GLADloadproc)glfwGetProcAddress, true);
+    ObjectData grid = configure_grid(window_size, game.board);
+    ObjectData body_cell = configure_body_cell();
+    ObjectData body_bridge = configure_body_bridge();
+    BodyMirror body_mirror;
+    init_body_mirror(&body_mirror);
+
+    // The board pass only knows the single game; arena mode keeps drawing instances.
+    BoardPass board_pass = {};
+    bool32 draws_board_pass = false;
+    if (uses_board_pass && client.arena) {
+        fprintf(stderr, "-B doesn't draw arena mode, drawing instances\n");
+    } else if (uses_board_pass) {
+        draws_board_pass = init_board_pass(&board_pass, &game.board);
+        if (!draws_board_pass) fprintf(stderr, "board too large for a texture, drawing instances\n");
+    }
 
-    FramerateData framerate = {10};
-    GameState game = {};
+    // Without -f, vsync paces the frames and the pacer only keeps their histogram, against the
+    // display's refresh rate.
+    FramePacer pacer;
+    const GLFWvidmode *display_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    u32 refresh_rate = display_mode && display_mode->refreshRate > 0 ? (u32)display_mode->refreshRate : 60;
+    init_frame_pacer(&pacer, frame_rate ? frame_rate : refresh_rate, FRAME_PACER_DEFAULT_SPIN_NS);
+    FrameStats frame_stats = {};
+    client.frame_stats = &frame_stats;
+    Profiler *profiler = (Profiler *)calloc(1, sizeof(Profiler));
+    client.profiler = profiler;
+    if (profile_path) set_profiler_enabled(profiler, true);
     restart_game(&game);
-    glfwSetWindowUserPointer(window, &game);
+    glfwSetWindowUserPointer(window, &client);
 
-    float cell_height = (float)window_size.y / CELL_COUNT;
-    glm::vec2 cell_size = glm::vec2(cell_height, cell_height);
+    ReplayRecorder recorder = {};
+    ReplayCursor replay_cursor = {};
+    if (replay_path) {
+        client.is_replaying = true;
+        if (!seek_replay(&replay, &game, &replay_cursor, replay_start)) {
+            fprintf(stderr, "replay %s is corrupt\n", replay_path);
+            return 1;
+        }
+    } else if (record_path) {
+        begin_recording(&recorder, &game, seed, REPLAY_DEFAULT_KEYFRAME_INTERVAL);
+        client.recorder = &recorder;
+    }
+
+    TickClock tick_clock;
+    init_tick_clock(&tick_clock, tick_rate);
 
     while (!glfwWindowShouldClose(window)) {
+        begin_frame_stats(&frame_stats);
+        profile_begin_frame(profiler);
         glfwPollEvents();
 
-        if (!game.is_over && !game.paused) {
-            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
+        bool32 is_running = !game.is_over && !game.paused;
+        // Restarting is how a finished game gets going again, so it can't wait for a tick.
+        if (!is_running && !client.arena && !client.is_replaying) apply_input(&client, &game.turns_queue, false);
 
-            update_snake(&game);
+        for (u32 due = advance_tick_clock(&tick_clock, is_running); due > 0 && !game.is_over && !game.paused; due--) {
+            u64 tick_start = platform_time_ns();
+            profile_begin(profiler, PROFILE_UPDATE);
+            client_tick(&client, &replay, &replay_cursor);
+            profile_end(profiler, PROFILE_UPDATE);
+            add_tick_time(&frame_stats, platform_time_ns() - tick_start);
+        }
+        float alpha = tick_clock_alpha(&tick_clock);
 
-            render_food(&cell, game.food_pos);
-            render_snake(&game.snake.tail, &cell, &bridge, cell_size);
-            render_object(&grid);
+        profile_begin(profiler, PROFILE_RENDER);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
 
-            glfwSwapBuffers(window);
+        CameraView view;
+        bool32 syncs_body_mirror = false;
+        bool32 draws_body_mirror = false;
+        clear_instance_batch(&batch);
+        if (client.arena) {
+            if (arena.snakes[0].alive) camera_follow(&client.camera, glm::vec2(tail_front(&arena.snakes[0].tail)->pos));
+            view = camera_view(&client.camera, &arena.board, window_size);
+            push_arena(&batch, &arena, &view);
+        } else {
+            camera_follow(&client.camera, snake_motion_head(&client.motion, &game.snake.tail, alpha));
+            view = camera_view(&client.camera, &game.board, window_size);
+
+            if (draws_board_pass) {
+                add_upload_bytes(&frame_stats, sync_board_pass(&board_pass, &game));
+            } else {
+                for (i32 i = 0; i < game.food_count; i++) {
+                    push_visible_food(&batch, &game.board, &view, game.food_pos[i]);
+                }
+                // Synced even when unused, so it never falls further behind than a frame's ticks.
+                syncs_body_mirror = true;
+                draws_body_mirror = body_fits_view(&game.snake.tail, &view);
+                if (!draws_body_mirror) {
+                    push_snake(&batch, &game.board, &game.map, &game.snake.tail, &body_index, &view,
+                               glm::vec3(1.0f, 0.0f, 0.0f), &client.motion, alpha);
+                }
+            }
+        }
+        u64 body_bytes = draws_body_mirror ? stream_space(&stream, sizeof(BodyData)) : 0;
+        if (draws_board_pass) body_bytes = stream_space(&stream, sizeof(BoardData));
+        if (syncs_body_mirror) body_bytes += body_mirror_stream_bytes(&body_mirror, &game.snake.tail, &stream);
+        begin_stream_frame(&stream, stream_space(&stream, sizeof(FrameData)) + instance_batch_bytes(&batch, &stream) + body_bytes);
+        if (syncs_body_mirror) {
+            add_upload_bytes(&frame_stats, sync_body_mirror(&body_mirror, &game.snake.tail, &stream));
+        }
+        apply_camera_view(&view, &frame_data, &stream);
+        if (draws_board_pass) {
+            render_board_pass(&board_pass, &stream, &game, &view, glm::vec3(1.0f, 0.0f, 0.0f), &client.motion, alpha);
+        } else {
+            render_instance_batch(&batch, &stream, &cell, &bridge);
+        }
+        if (draws_body_mirror) {
+            render_snake_body(&body_cell, &body_bridge, &body_mirror, &stream, &game.board, &game.snake.tail, &view,
+                              glm::vec3(1.0f, 0.0f, 0.0f), &client.motion, alpha);
         }
+        end_stream_frame(&stream);
+        profile_end(profiler, PROFILE_RENDER);
 
-        wait_until_next_frame(&framerate);
+        // The border marks the board's edges, which a scrolling view doesn't show. The board pass
+        // draws it itself.
+        profile_begin(profiler, PROFILE_GRID);
+        if (view.is_whole_board && !draws_board_pass) render_object(&grid);
+        profile_end(profiler, PROFILE_GRID);
+        render_profiler_overlay(profiler, window_size.x, window_size.y);
+
+        profile_begin(profiler, PROFILE_SWAP);
+        glfwSwapBuffers(window);
+        profile_end(profiler, PROFILE_SWAP);
+        report_frame_stats(&frame_stats, window, "OpenGL Snake");
+        if (frame_rate) {
+            wait_for_next_frame(&pacer);
+        } else {
+            record_frame(&pacer);
+        }
     }
 
+    if (client.recorder) {
+        if (!save_replay(&recorder, record_path)) fprintf(stderr, "can't write replay %s\n", record_path);
+        free_recorder(&recorder);
+    }
+    if (profile_path && !save_profile_csv(profiler, profile_path)) fprintf(stderr, "can't write %s\n", profile_path);
+    print_frame_pacer_report(&pacer);
+    free_profiler(profiler);
+    free(profiler);
+    close_replay(&replay);
+    if (client.arena) free_arena(&arena);
+    free_body_index(&body_index);
+    free_instance_batch(&batch);
+    free_stream_buffer(&stream);
+    free_body_mirror(&body_mirror);
+    if (draws_board_pass) free_board_pass(&board_pass);
+    free_input_queue(&client.input);
+    free_autopilot(&client.autopilot);
+    if (client.mcts) {
+        free_mcts(client.mcts);
+        delete client.mcts;
+    }
+    free_game(&game);
     glfwDestroyWindow(window);
     glfwTerminate();
     return 0;
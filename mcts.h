@@ -0,0 +1,396 @@
+#ifndef _MCTS_H_
+#define _MCTS_H_
+
+#include "typedefs.h"
+#include "board.h"
+#include "game.h"
+#include "snapshot.h"
+#include "rng.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <math.h>
+#include <mutex>
+#include <stdlib.h>
+#include <thread>
+
+// Monte Carlo tree search over the four turns, run on a pool of worker threads that share one
+// tree. Nodes are plain sequences of turns: a worker restores the root snapshot and replays the
+// turns on the way down, and since the food generator lives in the snapshot every worker sees
+// the same food. Virtual loss keeps workers from piling into the same branch. Nodes come from
+// a pool allocated up front and worker games are restored from snapshots, so the search loop
+// never touches the heap.
+//
+// mcts_search blocks for its budget. A caller that can't wait, like the render loop, starts
+// a search from the position after its tick with mcts_begin and takes the best turn found so
+// far with mcts_finish at the next one; the workers search while it draws.
+
+#define MCTS_MAX_NODES (1 << 18)
+#define MCTS_MAX_DEPTH 64
+#define MCTS_ROLLOUT_TICKS 64
+#define MCTS_VIRTUAL_LOSS 3
+#define MCTS_EXPLORATION 1.0
+#define MCTS_VALUE_SCALE 1000000.0
+// Share of the time between ticks a background search runs for, so it has ended by the time
+// the next tick takes its result.
+#define MCTS_TICK_SHARE 0.9
+// A background search that can't be used (it was for another position, or too few rollouts
+// came back, as when ticks run back to back to catch up) is replaced by a blocking one this
+// long.
+#define MCTS_FALLBACK_BUDGET 0.001
+#define MCTS_MIN_VISITS 64
+
+#define MCTS_UNEXPANDED -1
+#define MCTS_EXPANDING -2
+
+struct MctsNode {
+    std::atomic<i32> visits;
+    std::atomic<i32> children;
+    std::atomic<i64> value;
+    i32 direction;
+};
+
+// One per worker, padded so workers never share a cache line.
+struct alignas(64) MctsWorker {
+    GameState game;
+    Rng rng;
+    i32 path[MCTS_MAX_DEPTH + 1];
+    i64 rollouts;
+};
+
+struct MctsPool {
+    MctsNode *nodes;
+    std::atomic<i32> node_count;
+    u8 *root_snapshot;
+    MctsWorker *workers;
+    std::thread *threads;
+    i32 thread_count;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    u64 generation;
+    i32 running;
+    bool32 quit;
+    std::atomic<bool32> stop;
+    std::chrono::steady_clock::time_point deadline;
+
+    // The position the tree was searched from, and whether workers may still be searching it.
+    u64 root_key;
+    bool32 is_searching;
+};
+
+// How long a background search started right after a tick may run.
+double mcts_tick_budget(u32 tick_rate) {
+    return MCTS_TICK_SHARE / (tick_rate ? tick_rate : 1);
+}
+
+static void mcts_reset_node(MctsNode *node, i32 direction) {
+    node->visits.store(0, std::memory_order_relaxed);
+    node->children.store(MCTS_UNEXPANDED, std::memory_order_relaxed);
+    node->value.store(0, std::memory_order_relaxed);
+    node->direction = direction;
+}
+
+// Claims four child slots for `node`, skipping the reverse turn since the game ignores it.
+// Returns false if another worker is expanding the node or the pool is full.
+static bool32 mcts_expand(MctsPool *pool, MctsNode *node, GameState *game) {
+    i32 expected = MCTS_UNEXPANDED;
+    if (!node->children.compare_exchange_strong(expected, MCTS_EXPANDING, std::memory_order_acq_rel)) return false;
+
+    i32 first = pool->node_count.fetch_add(4, std::memory_order_relaxed);
+    if (first + 4 > MCTS_MAX_NODES) {
+        node->children.store(MCTS_UNEXPANDED, std::memory_order_release);
+        return false;
+    }
+
+    for (i32 i = 0; i < 4; i++) {
+        i32 direction = DIRECTION_UP + i;
+        bool32 is_reverse = direction_to_velocity(direction) + game->snake.velocity == glm::ivec2(0, 0);
+        mcts_reset_node(&pool->nodes[first + i], is_reverse ? DIRECTION_NONE : direction);
+    }
+
+    node->children.store(first, std::memory_order_release);
+    return true;
+}
+
+// UCT over the legal children; unvisited children go first.
+static i32 mcts_select(MctsPool *pool, MctsNode *node) {
+    i32 first = node->children.load(std::memory_order_acquire);
+    double log_parent = log((double)node->visits.load(std::memory_order_relaxed) + 1.0);
+    i32 best = -1;
+    double best_score = -1.0;
+
+    for (i32 i = 0; i < 4; i++) {
+        MctsNode *child = &pool->nodes[first + i];
+        if (child->direction == DIRECTION_NONE) continue;
+
+        i32 visits = child->visits.load(std::memory_order_relaxed);
+        if (visits == 0) return first + i;
+
+        double mean = child->value.load(std::memory_order_relaxed) / MCTS_VALUE_SCALE / visits;
+        double score = mean + MCTS_EXPLORATION * sqrt(log_parent / visits);
+        if (score > best_score) {
+            best_score = score;
+            best = first + i;
+        }
+    }
+
+    return best;
+}
+
+// Random walk that never steps straight into the body. Reward is 0 for dying, otherwise
+// 0.5 plus up to 0.5 for reaching food sooner.
+static double mcts_rollout(MctsWorker *worker, i32 ticks_done) {
+    GameState *game = &worker->game;
+    u32 neighbors[4];
+
+    for (i32 tick = ticks_done; tick < MCTS_ROLLOUT_TICKS; tick++) {
+        u32 head = board_index(&game->board, tail_front(&game->snake.tail)->pos);
+        board_neighbors(&game->board, head, neighbors);
+
+        i32 options[4], option_count = 0;
+        for (i32 i = 0; i < 4; i++) {
+            i32 direction = DIRECTION_UP + i;
+            if (direction_to_velocity(direction) + game->snake.velocity == glm::ivec2(0, 0)) continue;
+            if (!map_at(&game->map, neighbors[i])) options[option_count++] = direction;
+        }
+        if (option_count) push_queue(&game->turns_queue, options[rng_below(&worker->rng, option_count)]);
+
+        TickResult result = update_snake(game);
+        if (result == TICK_DIED) return 0.0;
+        if (result == TICK_ATE || result == TICK_WON) return 1.0 - 0.5 * tick / MCTS_ROLLOUT_TICKS;
+    }
+
+    return 0.5;
+}
+
+static void mcts_iterate(MctsPool *pool, MctsWorker *worker) {
+    GameState *game = &worker->game;
+    restore_snapshot(game, pool->root_snapshot);
+
+    i32 depth = 0;
+    i32 index = 0;
+    worker->path[0] = 0;
+    pool->nodes[0].visits.fetch_add(MCTS_VIRTUAL_LOSS, std::memory_order_relaxed);
+
+    double reward = -1.0;
+    while (depth < MCTS_MAX_DEPTH) {
+        MctsNode *node = &pool->nodes[index];
+        if (node->children.load(std::memory_order_acquire) < 0 && !mcts_expand(pool, node, game)) break;
+
+        i32 child = mcts_select(pool, node);
+        if (child < 0) break;
+
+        worker->path[++depth] = child;
+        pool->nodes[child].visits.fetch_add(MCTS_VIRTUAL_LOSS, std::memory_order_relaxed);
+        push_queue(&game->turns_queue, pool->nodes[child].direction);
+
+        TickResult result = update_snake(game);
+        if (result == TICK_DIED) {
+            reward = 0.0;
+            break;
+        }
+        if (result == TICK_ATE || result == TICK_WON) {
+            reward = 1.0 - 0.5 * depth / MCTS_ROLLOUT_TICKS;
+            break;
+        }
+
+        index = child;
+        if (pool->nodes[child].visits.load(std::memory_order_relaxed) <= MCTS_VIRTUAL_LOSS) break;
+    }
+
+    if (reward < 0.0) reward = mcts_rollout(worker, depth);
+
+    i64 value = (i64)(reward * MCTS_VALUE_SCALE);
+    for (i32 i = 0; i <= depth; i++) {
+        MctsNode *node = &pool->nodes[worker->path[i]];
+        node->value.fetch_add(value, std::memory_order_relaxed);
+        node->visits.fetch_add(1 - MCTS_VIRTUAL_LOSS, std::memory_order_relaxed);
+    }
+    worker->rollouts++;
+}
+
+static void mcts_worker_main(MctsPool *pool, i32 worker_index) {
+    MctsWorker *worker = &pool->workers[worker_index];
+    u64 seen_generation = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&] { return pool->quit || pool->generation != seen_generation; });
+            if (pool->quit) return;
+            seen_generation = pool->generation;
+        }
+
+        while (!pool->stop.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < pool->deadline) {
+            mcts_iterate(pool, worker);
+        }
+
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--pool->running == 0) pool->done.notify_one();
+    }
+}
+
+void init_mcts(MctsPool *pool, const Board *board, i32 thread_count, u64 seed) {
+    pool->thread_count = thread_count < 1 ? 1 : thread_count;
+    pool->nodes = new MctsNode[MCTS_MAX_NODES];
+    pool->node_count = 0;
+    pool->workers = new MctsWorker[pool->thread_count];
+    pool->threads = new std::thread[pool->thread_count];
+    pool->generation = 0;
+    pool->running = 0;
+    pool->quit = false;
+    pool->stop = false;
+    pool->is_searching = false;
+
+    for (i32 i = 0; i < pool->thread_count; i++) {
+        MctsWorker *worker = &pool->workers[i];
+        worker->game = {};
+        init_game(&worker->game, board->width, board->height);
+        worker->rng = rng_split(seed, (u64)i);
+        worker->rollouts = 0;
+    }
+    pool->root_snapshot = (u8 *)malloc(snapshot_capacity(&pool->workers[0].game));
+
+    for (i32 i = 0; i < pool->thread_count; i++) {
+        pool->threads[i] = std::thread(mcts_worker_main, pool, i);
+    }
+}
+
+void free_mcts(MctsPool *pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->quit = true;
+        pool->stop = true;
+    }
+    pool->wake.notify_all();
+
+    for (i32 i = 0; i < pool->thread_count; i++) {
+        pool->threads[i].join();
+        free_game(&pool->workers[i].game);
+    }
+
+    delete[] pool->threads;
+    delete[] pool->workers;
+    delete[] pool->nodes;
+    free(pool->root_snapshot);
+}
+
+// Tells positions apart without comparing whole snapshots: the generator moves on with every
+// food placed, and the head, length and heading cover turns, growth and restarts.
+static u64 mcts_game_key(GameState *game) {
+    TailRing *tail = &game->snake.tail;
+    u64 key = game->rng.s[0] ^ rotl64(game->rng.s[1], 16) ^ rotl64(game->rng.s[2], 32) ^ rotl64(game->rng.s[3], 48);
+    key ^= board_index(&game->board, tail_front(tail)->pos) * 0x9e3779b97f4a7c15ull;
+    key ^= board_index(&game->board, tail_back(tail)->pos) * 0xc2b2ae3d27d4eb4full;
+    u64 shape = (u64)tail->size << 8 | (u64)velocity_to_direction(game->snake.velocity) << 2 |
+                (u64)(game->snake.should_grow != 0) << 1 | (u64)(game->turns_queue.size > 0);
+    return key ^ shape * 0x165667b19e3779f9ull;
+}
+
+static void mcts_start(MctsPool *pool, GameState *game, double budget) {
+    save_snapshot(game, pool->root_snapshot);
+    pool->root_key = mcts_game_key(game);
+    pool->node_count = 1;
+    mcts_reset_node(&pool->nodes[0], DIRECTION_NONE);
+
+    for (i32 i = 0; i < pool->thread_count; i++) {
+        pool->workers[i].rollouts = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->deadline = std::chrono::steady_clock::now() +
+                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(budget));
+    pool->stop = false;
+    pool->running = pool->thread_count;
+    pool->generation++;
+    pool->wake.notify_all();
+}
+
+static void mcts_wait(MctsPool *pool) {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->done.wait(lock, [&] { return pool->running == 0; });
+}
+
+// The most visited turn from the root, or DIRECTION_NONE if it was never expanded.
+static i32 mcts_best_direction(MctsPool *pool) {
+    MctsNode *root = &pool->nodes[0];
+    i32 first = root->children.load(std::memory_order_acquire);
+    if (first < 0) return DIRECTION_NONE;
+
+    i32 best_direction = DIRECTION_NONE;
+    i32 best_visits = -1;
+    for (i32 i = 0; i < 4; i++) {
+        MctsNode *child = &pool->nodes[first + i];
+        i32 visits = child->visits.load(std::memory_order_relaxed);
+        if (child->direction != DIRECTION_NONE && visits > best_visits) {
+            best_visits = visits;
+            best_direction = child->direction;
+        }
+    }
+    return best_direction;
+}
+
+// Stops a background search and waits the few microseconds the workers need to finish their
+// current playout.
+void mcts_cancel(MctsPool *pool) {
+    if (!pool->is_searching) return;
+    pool->stop = true;
+    mcts_wait(pool);
+    pool->is_searching = false;
+}
+
+// Searches from `game` for `budget` seconds and returns the most visited turn. `rollouts`
+// (optional) receives the number of playouts run.
+i32 mcts_search(MctsPool *pool, GameState *game, double budget, i64 *rollouts) {
+    mcts_cancel(pool);
+    mcts_start(pool, game, budget);
+    mcts_wait(pool);
+
+    if (rollouts) {
+        *rollouts = 0;
+        for (i32 i = 0; i < pool->thread_count; i++) {
+            *rollouts += pool->workers[i].rollouts;
+        }
+    }
+    return mcts_best_direction(pool);
+}
+
+// Starts searching from `game` in the background for at most `budget` seconds and returns at
+// once. `game` may change afterwards; the search works on its own copy.
+void mcts_begin(MctsPool *pool, GameState *game, double budget) {
+    mcts_cancel(pool);
+    mcts_start(pool, game, budget);
+    pool->is_searching = true;
+}
+
+// The best turn from `game`, taken from the background search when it was started from this
+// same position and got far enough, otherwise from a short blocking search.
+i32 mcts_finish(MctsPool *pool, GameState *game) {
+    bool32 was_searching = pool->is_searching;
+    mcts_cancel(pool);
+
+    bool32 is_usable = was_searching && pool->root_key == mcts_game_key(game) &&
+                       pool->nodes[0].visits.load(std::memory_order_relaxed) >= MCTS_MIN_VISITS;
+    if (!is_usable) return mcts_search(pool, game, MCTS_FALLBACK_BUDGET, NULL);
+    return mcts_best_direction(pool);
+}
+
+// Queues the searched turn; returns it, or DIRECTION_NONE when the snake keeps going straight.
+// Takes the result of the background search, see mcts_finish; call mcts_begin after the tick.
+i32 mcts_steer(MctsPool *pool, GameState *game) {
+    if (game->turns_queue.size > 0) {
+        mcts_cancel(pool);
+        return DIRECTION_NONE;
+    }
+
+    i32 direction = mcts_finish(pool, game);
+    if (!direction || direction == velocity_to_direction(game->snake.velocity)) return DIRECTION_NONE;
+
+    push_queue(&game->turns_queue, direction);
+    return direction;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef _OBJECT_H_
+#define _OBJECT_H_
+
+#include "typedefs.h"
+#include "shader.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+struct Vertex {
+    glm::vec2 pos;
+};
+
+struct ObjectData {
+    u32 vao;
+    u32 vbo;
+    u32 vertex_count;
+    ShaderProgram shader;
+    u32 primitive;
+};
+
+void render_object(ObjectData *object) {
+    glUseProgram(object->shader.id);
+    glBindVertexArray(object->vao);
+    glDrawArrays(object->primitive, 0, object->vertex_count);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+#endif
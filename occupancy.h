@@ -0,0 +1,106 @@
+#ifndef _OCCUPANCY_H_
+#define _OCCUPANCY_H_
+
+#include "typedefs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__BMI2__)
+    #include <immintrin.h>
+#endif
+
+// One bit per cell, indexed by board_index(). The word count is padded to whole 256-bit
+// lanes and bits past the last cell are kept set so they never read as free.
+struct OccupancyGrid {
+    u64 *words;
+    u32 word_count;
+    u32 cell_count;
+};
+
+static u32 map_word_count(u32 cell_count) {
+    return ((cell_count + 255) / 256) * 4;
+}
+
+void init_map(OccupancyGrid *map, u32 cell_count) {
+    map->cell_count = cell_count;
+    map->word_count = map_word_count(cell_count);
+    map->words = (u64 *)malloc(map->word_count * sizeof(u64));
+}
+
+void free_map(OccupancyGrid *map) {
+    free(map->words);
+    map->words = NULL;
+    map->word_count = 0;
+    map->cell_count = 0;
+}
+
+static void map_set(OccupancyGrid *map, u32 index, i32 value) {
+    u64 bit = 1ull << (index & 63);
+    if (value) {
+        map->words[index >> 6] |= bit;
+    } else {
+        map->words[index >> 6] &= ~bit;
+    }
+}
+
+static bool32 map_at(OccupancyGrid *map, u32 index) {
+    return (map->words[index >> 6] >> (index & 63)) & 1;
+}
+
+static void map_clear(OccupancyGrid *map) {
+    memset(map->words, 0, map->word_count * sizeof(u64));
+
+    for (u32 bit = map->cell_count; bit < map->word_count * 64; bit++) {
+        map->words[bit >> 6] |= 1ull << (bit & 63);
+    }
+}
+
+#if defined(__AVX2__)
+static __m256i popcount_epi64(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+#endif
+
+static u32 select_bit(u64 bits, u32 n) {
+#if defined(__BMI2__)
+    return __builtin_ctzll(_pdep_u64(1ull << n, bits));
+#else
+    for (u32 i = 0; i < n; i++) bits &= bits - 1;
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// Index of the n-th free cell in row-major order; -1 if there are not that many. Whole
+// 256-bit lanes are skipped on their popcount, so the scan is one step per 256 cells.
+static i32 map_nth_free(OccupancyGrid *map, u32 n) {
+    u32 i = 0;
+
+#if defined(__AVX2__)
+    for (; i < map->word_count; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(map->words + i));
+        __m256i used = popcount_epi64(v);
+        u32 count = 256 - (u32)(_mm256_extract_epi64(used, 0) + _mm256_extract_epi64(used, 1) +
+                                _mm256_extract_epi64(used, 2) + _mm256_extract_epi64(used, 3));
+        if (n < count) break;
+        n -= count;
+    }
+#endif
+
+    for (; i < map->word_count; i++) {
+        u64 free_bits = ~map->words[i];
+        u32 count = __builtin_popcountll(free_bits);
+        if (n < count) return (i32)(i * 64 + select_bit(free_bits, n));
+        n -= count;
+    }
+
+    return -1;
+}
+
+#endif
@@ -7,6 +7,11 @@
     #include <Windows.h>
 #elif defined(__unix__)
     #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <errno.h>
 #endif
 
 void platform_sleep(u32 milliseconds) {
@@ -17,4 +22,154 @@ void platform_sleep(u32 milliseconds) {
     #endif
 }
 
+// Monotonic clock in nanoseconds, for timestamps and intervals only.
+u64 platform_time_ns() {
+    #if defined(_WIN32)
+        static LARGE_INTEGER frequency;
+        if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return (u64)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+    #elif defined(__unix__)
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+    #endif
+}
+
+// Sleeps until platform_time_ns() reaches `deadline_ns`. An absolute deadline doesn't add the
+// time spent computing the sleep to it, and an interrupted sleep resumes to the same deadline.
+void platform_sleep_until_ns(u64 deadline_ns) {
+    #if defined(_WIN32)
+        u64 now = platform_time_ns();
+        if (deadline_ns > now) Sleep((DWORD)((deadline_ns - now) / 1000000));
+    #elif defined(__unix__)
+        struct timespec deadline;
+        deadline.tv_sec = (time_t)(deadline_ns / 1000000000ull);
+        deadline.tv_nsec = (long)(deadline_ns % 1000000000ull);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+    #endif
+}
+
+// Maps a whole file read-only. Returns NULL if it can't be opened or is empty.
+const u8 *platform_map_file(const char *path, u64 *size) {
+    #if defined(_WIN32)
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return NULL;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(file);
+            return NULL;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(file);
+        if (!mapping) return NULL;
+
+        const u8 *data = (const u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        *size = (u64)file_size.QuadPart;
+        return data;
+    #elif defined(__unix__)
+        i32 fd = open(path, O_RDONLY);
+        if (fd < 0) return NULL;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return NULL;
+        }
+
+        void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return NULL;
+
+        *size = (u64)info.st_size;
+        return (const u8 *)data;
+    #endif
+}
+
+void platform_unmap_file(const u8 *data, u64 size) {
+    #if defined(_WIN32)
+        UnmapViewOfFile(data);
+    #elif defined(__unix__)
+        munmap((void *)data, (size_t)size);
+    #endif
+}
+
+// Creates (or replaces) a named shared-memory segment of `size` zeroed bytes, mapped read-write.
+// POSIX names look like "/name".
+u8 *platform_create_shared(const char *name, u64 size) {
+    #if defined(_WIN32)
+        HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, name);
+        if (!mapping) return NULL;
+
+        u8 *data = (u8 *)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+        CloseHandle(mapping);
+        return data;
+    #elif defined(__unix__)
+        shm_unlink(name);
+        i32 fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) return NULL;
+
+        if (ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            shm_unlink(name);
+            return NULL;
+        }
+
+        void *data = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            shm_unlink(name);
+            return NULL;
+        }
+        return (u8 *)data;
+    #endif
+}
+
+// Maps an existing segment read-write. Returns NULL if it doesn't exist.
+u8 *platform_open_shared(const char *name, u64 *size) {
+    #if defined(_WIN32)
+        HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+        if (!mapping) return NULL;
+
+        u8 *data = (u8 *)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!data) return NULL;
+
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(data, &info, sizeof(info));
+        *size = (u64)info.RegionSize;
+        return data;
+    #elif defined(__unix__)
+        i32 fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0) return NULL;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return NULL;
+        }
+
+        void *data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return NULL;
+
+        *size = (u64)info.st_size;
+        return (u8 *)data;
+    #endif
+}
+
+// Unmaps a segment; `name` also removes it once every process has unmapped it.
+void platform_close_shared(u8 *data, u64 size, const char *name) {
+    #if defined(_WIN32)
+        UnmapViewOfFile(data);
+    #elif defined(__unix__)
+        munmap(data, (size_t)size);
+        if (name) shm_unlink(name);
+    #endif
+}
+
 #endif
@@ -0,0 +1,241 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include "typedefs.h"
+#include "platform.h"
+#include "gl_calls.h"
+
+#include <glad/glad.h>
+#include <stdio.h>
+#include <string.h>
+
+// Per-frame timing of the main loop's phases. CPU time comes from the monotonic clock; phases
+// that issue GL work are also wrapped in GL_TIME_ELAPSED queries. Those are read back
+// PROFILER_QUERY_FRAMES frames later, and only once their results are available, so reading
+// them never waits on the GPU. A frame whose results never showed up keeps gpu_ns at -1.
+//
+// Each frame also records how many GL calls it made (gl_calls.h), the profiler's own queries
+// included.
+//
+// Frames go into a ring of the last PROFILER_HISTORY frames, which can be drawn as an overlay
+// of bars and written out as CSV. When disabled, every call returns after one branch.
+//
+// GL_TIME_ELAPSED queries can't nest, so GPU phases must not overlap, and each GPU phase may
+// run once per frame. CPU-only phases may run any number of times; their time adds up.
+
+#define PROFILER_HISTORY 512
+#define PROFILER_QUERY_FRAMES 4
+// Overlay bars: pixels per millisecond, bar height, and how many frames each bar averages.
+#define PROFILER_OVERLAY_PIXELS_PER_MS 40
+#define PROFILER_OVERLAY_BAR_HEIGHT 8
+#define PROFILER_OVERLAY_FRAMES 30
+
+enum ProfilePhase {
+    PROFILE_UPDATE,
+    PROFILE_RENDER,
+    PROFILE_GRID,
+    PROFILE_SWAP,
+    PROFILE_PHASE_COUNT,
+};
+
+static const char *profile_phase_names[PROFILE_PHASE_COUNT] = { "update", "render", "grid", "swap" };
+// Swapping only waits on the driver, so its GPU side is left untimed.
+static const bool32 profile_phase_has_gpu[PROFILE_PHASE_COUNT] = { false, true, true, false };
+static const float profile_phase_colors[PROFILE_PHASE_COUNT][3] = {
+    { 0.2f, 0.8f, 0.2f }, { 1.0f, 0.5f, 0.1f }, { 0.3f, 0.6f, 1.0f }, { 0.8f, 0.3f, 0.8f },
+};
+
+struct ProfileFrame {
+    u64 index;
+    u64 frame_ns;
+    u64 gl_calls;
+    u64 cpu_ns[PROFILE_PHASE_COUNT];
+    i64 gpu_ns[PROFILE_PHASE_COUNT];
+};
+
+struct Profiler {
+    bool32 is_enabled;
+    bool32 shows_overlay;
+    bool32 has_queries;
+
+    u64 frame_index;
+    u64 frame_start;
+    u64 frame_gl_calls;
+    u64 phase_start[PROFILE_PHASE_COUNT];
+    ProfileFrame frames[PROFILER_HISTORY];
+    u64 recorded;
+
+    u32 queries[PROFILER_QUERY_FRAMES][PROFILE_PHASE_COUNT];
+    // Frame whose results each query set holds, +1; 0 when it has none pending.
+    u64 query_frame[PROFILER_QUERY_FRAMES];
+};
+
+static ProfileFrame *profile_frame(Profiler *profiler, u64 index) {
+    return &profiler->frames[index % PROFILER_HISTORY];
+}
+
+// Needs a current GL context, as the queries are created and GL calls start being counted on
+// first use.
+void set_profiler_enabled(Profiler *profiler, bool32 is_enabled) {
+    if (is_enabled && !profiler->has_queries) {
+        glGenQueries(PROFILER_QUERY_FRAMES * PROFILE_PHASE_COUNT, &profiler->queries[0][0]);
+        profiler->has_queries = true;
+        count_gl_calls();
+    }
+    // Results still in flight would land on frames that are recorded again from scratch.
+    memset(profiler->query_frame, 0, sizeof(profiler->query_frame));
+    profiler->frame_start = 0;
+    profiler->is_enabled = is_enabled;
+}
+
+void free_profiler(Profiler *profiler) {
+    if (profiler->has_queries) glDeleteQueries(PROFILER_QUERY_FRAMES * PROFILE_PHASE_COUNT, &profiler->queries[0][0]);
+    profiler->has_queries = false;
+}
+
+// Collects the GPU results of the frame that last used this frame's query set.
+static void collect_gpu_times(Profiler *profiler, u32 set) {
+    u64 pending = profiler->query_frame[set];
+    if (!pending) return;
+    profiler->query_frame[set] = 0;
+
+    ProfileFrame *frame = profile_frame(profiler, pending - 1);
+    if (frame->index != pending - 1) return;
+
+    for (i32 phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        if (!profile_phase_has_gpu[phase]) continue;
+
+        u32 query = profiler->queries[set][phase];
+        GLuint64 is_available = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT_AVAILABLE, &is_available);
+        if (!is_available) continue;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        frame->gpu_ns[phase] = (i64)elapsed;
+    }
+}
+
+void profile_begin_frame(Profiler *profiler) {
+    if (!profiler->is_enabled) return;
+
+    u64 now = platform_time_ns();
+    if (profiler->frame_start) {
+        ProfileFrame *last = profile_frame(profiler, profiler->frame_index);
+        last->frame_ns = now - profiler->frame_start;
+        last->gl_calls = gl_call_count - profiler->frame_gl_calls;
+        profiler->frame_index++;
+        profiler->recorded++;
+    }
+    profiler->frame_start = now;
+    profiler->frame_gl_calls = gl_call_count;
+
+    collect_gpu_times(profiler, profiler->frame_index % PROFILER_QUERY_FRAMES);
+
+    ProfileFrame *frame = profile_frame(profiler, profiler->frame_index);
+    frame->index = profiler->frame_index;
+    frame->frame_ns = 0;
+    frame->gl_calls = 0;
+    for (i32 phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        frame->cpu_ns[phase] = 0;
+        frame->gpu_ns[phase] = -1;
+    }
+}
+
+void profile_begin(Profiler *profiler, i32 phase) {
+    if (!profiler->is_enabled) return;
+
+    if (profile_phase_has_gpu[phase]) {
+        u32 set = profiler->frame_index % PROFILER_QUERY_FRAMES;
+        glBeginQuery(GL_TIME_ELAPSED, profiler->queries[set][phase]);
+    }
+    profiler->phase_start[phase] = platform_time_ns();
+}
+
+void profile_end(Profiler *profiler, i32 phase) {
+    if (!profiler->is_enabled) return;
+
+    profile_frame(profiler, profiler->frame_index)->cpu_ns[phase] += platform_time_ns() - profiler->phase_start[phase];
+    if (profile_phase_has_gpu[phase]) {
+        glEndQuery(GL_TIME_ELAPSED);
+        profiler->query_frame[profiler->frame_index % PROFILER_QUERY_FRAMES] = profiler->frame_index + 1;
+    }
+}
+
+// Bars in the bottom-left corner, one row per phase: CPU time in the phase's color with the
+// GPU time in a darker shade below it, averaged over the last PROFILER_OVERLAY_FRAMES frames.
+// Drawn with scissored clears, so it needs no shader or buffers of its own.
+void render_profiler_overlay(Profiler *profiler, i32 window_width, i32 window_height) {
+    if (!profiler->is_enabled || !profiler->shows_overlay || !profiler->recorded) return;
+
+    u64 frame_count = profiler->recorded < PROFILER_OVERLAY_FRAMES ? profiler->recorded : PROFILER_OVERLAY_FRAMES;
+    glViewport(0, 0, window_width, window_height);
+    glEnable(GL_SCISSOR_TEST);
+
+    for (i32 phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        u64 cpu_ns = 0, gpu_ns = 0, gpu_frames = 0;
+        for (u64 i = 1; i <= frame_count; i++) {
+            ProfileFrame *frame = profile_frame(profiler, profiler->frame_index - i);
+            cpu_ns += frame->cpu_ns[phase];
+            if (frame->gpu_ns[phase] >= 0) {
+                gpu_ns += (u64)frame->gpu_ns[phase];
+                gpu_frames++;
+            }
+        }
+
+        const float *color = profile_phase_colors[phase];
+        i32 y = PROFILER_OVERLAY_BAR_HEIGHT * (1 + 3 * (PROFILE_PHASE_COUNT - 1 - phase));
+        i32 cpu_width = (i32)(cpu_ns / 1e6 / frame_count * PROFILER_OVERLAY_PIXELS_PER_MS) + 1;
+        glScissor(PROFILER_OVERLAY_BAR_HEIGHT, y + PROFILER_OVERLAY_BAR_HEIGHT, cpu_width, PROFILER_OVERLAY_BAR_HEIGHT);
+        glClearColor(color[0], color[1], color[2], 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        if (gpu_frames) {
+            i32 gpu_width = (i32)(gpu_ns / 1e6 / gpu_frames * PROFILER_OVERLAY_PIXELS_PER_MS) + 1;
+            glScissor(PROFILER_OVERLAY_BAR_HEIGHT, y, gpu_width, PROFILER_OVERLAY_BAR_HEIGHT);
+            glClearColor(color[0] * 0.5f, color[1] * 0.5f, color[2] * 0.5f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// Writes the recorded frames, oldest first, in milliseconds. GPU times that never arrived are
+// left empty.
+bool32 save_profile_csv(Profiler *profiler, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "frame,frame_ms,gl_calls");
+    for (i32 phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        fprintf(file, ",%s_cpu_ms", profile_phase_names[phase]);
+        if (profile_phase_has_gpu[phase]) fprintf(file, ",%s_gpu_ms", profile_phase_names[phase]);
+    }
+    fprintf(file, "\n");
+
+    // The slot after the newest frame holds the one in progress.
+    u64 count = profiler->recorded < PROFILER_HISTORY - 1 ? profiler->recorded : PROFILER_HISTORY - 1;
+    for (u64 i = count; i > 0; i--) {
+        ProfileFrame *frame = profile_frame(profiler, profiler->frame_index - i);
+        fprintf(file, "%llu,%.4f,%llu", (unsigned long long)frame->index, frame->frame_ns / 1e6,
+                (unsigned long long)frame->gl_calls);
+        for (i32 phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+            fprintf(file, ",%.4f", frame->cpu_ns[phase] / 1e6);
+            if (!profile_phase_has_gpu[phase]) continue;
+            if (frame->gpu_ns[phase] >= 0) {
+                fprintf(file, ",%.4f", frame->gpu_ns[phase] / 1e6);
+            } else {
+                fprintf(file, ",");
+            }
+        }
+        fprintf(file, "\n");
+    }
+
+    bool32 is_ok = !ferror(file);
+    fclose(file);
+    return is_ok;
+}
+
+#endif
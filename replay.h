@@ -0,0 +1,288 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include "typedefs.h"
+#include "platform.h"
+#include "byte_buffer.h"
+#include "game.h"
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Replay file layout (all integers little-endian):
+//
+//   header      REPLAY_HEADER_SIZE bytes, see write_replay_header()
+//   events      one varint per input: (ticks since previous event << 3) | ReplayEvent
+//   keyframes   full game states every keyframe_interval ticks, see encode_game_state()
+//   index       keyframe_count x { u64 tick, u64 file offset of the keyframe }
+//
+// A tick is one update_snake call; events recorded at tick t are applied before update t.
+// Seeking restores the nearest keyframe at or before the target and replays the inputs
+// from there, so it costs O(keyframe interval) rather than O(game length).
+
+#define REPLAY_MAGIC "SNKR"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 80
+#define REPLAY_INDEX_ENTRY_SIZE 16
+#define REPLAY_DEFAULT_KEYFRAME_INTERVAL 1024
+
+enum ReplayEvent {
+    // DIRECTION_UP..DIRECTION_LEFT are turns passed to push_queue.
+    REPLAY_EVENT_GROW = 5,
+    REPLAY_EVENT_RESTART = 6,
+};
+
+struct ReplayHeader {
+    u32 version;
+    i32 width;
+    i32 height;
+    i32 food_target;
+    u32 keyframe_interval;
+    u64 seed;
+    u64 tick_count;
+    u64 event_count;
+    u64 events_offset;
+    u64 events_size;
+    u64 index_offset;
+    u64 keyframe_count;
+};
+
+struct ReplayRecorder {
+    ReplayHeader header;
+    ByteBuffer events;
+    ByteBuffer keyframes;
+    ByteBuffer index;
+    u64 tick;
+    u64 last_event_tick;
+};
+
+struct Replay {
+    const u8 *data;
+    u64 size;
+    ReplayHeader header;
+};
+
+struct ReplayCursor {
+    ByteReader events;
+    u64 tick;
+    u64 next_event_tick;
+    i32 next_event;
+};
+
+static void write_replay_header(ByteBuffer *buffer, ReplayHeader *header) {
+    write_bytes(buffer, REPLAY_MAGIC, 4);
+    write_u32(buffer, header->version);
+    write_u32(buffer, (u32)header->width);
+    write_u32(buffer, (u32)header->height);
+    write_u32(buffer, (u32)header->food_target);
+    write_u32(buffer, header->keyframe_interval);
+    write_u64(buffer, header->seed);
+    write_u64(buffer, header->tick_count);
+    write_u64(buffer, header->event_count);
+    write_u64(buffer, header->events_offset);
+    write_u64(buffer, header->events_size);
+    write_u64(buffer, header->index_offset);
+    write_u64(buffer, header->keyframe_count);
+}
+
+static bool32 read_replay_header(ByteReader *reader, ReplayHeader *header) {
+    char magic[4];
+    read_bytes(reader, magic, 4);
+    header->version = read_u32(reader);
+    header->width = (i32)read_u32(reader);
+    header->height = (i32)read_u32(reader);
+    header->food_target = (i32)read_u32(reader);
+    header->keyframe_interval = read_u32(reader);
+    header->seed = read_u64(reader);
+    header->tick_count = read_u64(reader);
+    header->event_count = read_u64(reader);
+    header->events_offset = read_u64(reader);
+    header->events_size = read_u64(reader);
+    header->index_offset = read_u64(reader);
+    header->keyframe_count = read_u64(reader);
+
+    return reader->ok && !memcmp(magic, REPLAY_MAGIC, 4) && header->version == REPLAY_VERSION;
+}
+
+static void take_keyframe(ReplayRecorder *recorder, GameState *game) {
+    write_u64(&recorder->index, recorder->tick);
+    write_u64(&recorder->index, recorder->keyframes.size);
+
+    write_varint(&recorder->keyframes, recorder->events.size);
+    write_varint(&recorder->keyframes, recorder->last_event_tick);
+    encode_game_state(&recorder->keyframes, game);
+    recorder->header.keyframe_count++;
+}
+
+// Starts recording `game` from its current state, which becomes keyframe 0.
+void begin_recording(ReplayRecorder *recorder, GameState *game, u64 seed, u32 keyframe_interval) {
+    memset(recorder, 0, sizeof(*recorder));
+    recorder->header.version = REPLAY_VERSION;
+    recorder->header.width = game->board.width;
+    recorder->header.height = game->board.height;
+    recorder->header.food_target = game->food_target;
+    recorder->header.keyframe_interval = keyframe_interval ? keyframe_interval : REPLAY_DEFAULT_KEYFRAME_INTERVAL;
+    recorder->header.seed = seed;
+
+    take_keyframe(recorder, game);
+}
+
+// Call for every input applied to the game before the next update_snake.
+void record_event(ReplayRecorder *recorder, i32 event) {
+    write_varint(&recorder->events, ((recorder->tick - recorder->last_event_tick) << 3) | (u64)event);
+    recorder->last_event_tick = recorder->tick;
+    recorder->header.event_count++;
+}
+
+// Call after every update_snake.
+void record_tick(ReplayRecorder *recorder, GameState *game) {
+    recorder->tick++;
+    if (recorder->tick % recorder->header.keyframe_interval == 0) {
+        take_keyframe(recorder, game);
+    }
+}
+
+bool32 save_replay(ReplayRecorder *recorder, const char *path) {
+    ReplayHeader *header = &recorder->header;
+    header->tick_count = recorder->tick;
+    header->events_offset = REPLAY_HEADER_SIZE;
+    header->events_size = recorder->events.size;
+
+    u64 keyframes_offset = header->events_offset + header->events_size;
+    header->index_offset = keyframes_offset + recorder->keyframes.size;
+
+    ByteBuffer header_bytes = {};
+    write_replay_header(&header_bytes, header);
+
+    ByteReader index = make_reader(recorder->index.data, recorder->index.size);
+    ByteBuffer index_bytes = {};
+    for (u64 i = 0; i < header->keyframe_count; i++) {
+        write_u64(&index_bytes, read_u64(&index));
+        write_u64(&index_bytes, keyframes_offset + read_u64(&index));
+    }
+
+    FILE *file = fopen(path, "wb");
+    bool32 success = file != NULL;
+    if (file) {
+        success = fwrite(header_bytes.data, 1, header_bytes.size, file) == header_bytes.size &&
+                  fwrite(recorder->events.data, 1, recorder->events.size, file) == recorder->events.size &&
+                  fwrite(recorder->keyframes.data, 1, recorder->keyframes.size, file) == recorder->keyframes.size &&
+                  fwrite(index_bytes.data, 1, index_bytes.size, file) == index_bytes.size;
+        success = fclose(file) == 0 && success;
+    }
+
+    free_buffer(&header_bytes);
+    free_buffer(&index_bytes);
+    return success;
+}
+
+void free_recorder(ReplayRecorder *recorder) {
+    free_buffer(&recorder->events);
+    free_buffer(&recorder->keyframes);
+    free_buffer(&recorder->index);
+}
+
+bool32 open_replay(Replay *replay, const char *path) {
+    replay->data = platform_map_file(path, &replay->size);
+    if (!replay->data) return false;
+
+    ByteReader reader = make_reader(replay->data, replay->size);
+    ReplayHeader *header = &replay->header;
+    bool32 valid = read_replay_header(&reader, header) &&
+                   header->keyframe_count > 0 &&
+                   header->events_offset + header->events_size <= replay->size &&
+                   header->index_offset + header->keyframe_count * REPLAY_INDEX_ENTRY_SIZE <= replay->size;
+
+    if (!valid) {
+        platform_unmap_file(replay->data, replay->size);
+        replay->data = NULL;
+    }
+    return valid;
+}
+
+void close_replay(Replay *replay) {
+    if (replay->data) platform_unmap_file(replay->data, replay->size);
+    replay->data = NULL;
+}
+
+static void read_next_event(ReplayCursor *cursor) {
+    if (cursor->events.cursor >= cursor->events.end) {
+        cursor->next_event = 0;
+        cursor->next_event_tick = ~0ull;
+        return;
+    }
+
+    u64 value = read_varint(&cursor->events);
+    cursor->next_event = (i32)(value & 7);
+    cursor->next_event_tick += value >> 3;
+}
+
+static void apply_replay_event(GameState *game, i32 event) {
+    switch (event) {
+        case REPLAY_EVENT_GROW: game->snake.should_grow = true; break;
+        case REPLAY_EVENT_RESTART: restart_game(game); break;
+        default: push_queue(&game->turns_queue, event); break;
+    }
+}
+
+// Advances the replay by one tick. Returns false once every recorded tick has been played.
+bool32 step_replay(Replay *replay, GameState *game, ReplayCursor *cursor, TickResult *result) {
+    if (cursor->tick >= replay->header.tick_count) return false;
+
+    while (cursor->next_event && cursor->next_event_tick == cursor->tick) {
+        apply_replay_event(game, cursor->next_event);
+        read_next_event(cursor);
+    }
+
+    TickResult tick_result = update_snake(game);
+    if (result) *result = tick_result;
+    cursor->tick++;
+    return true;
+}
+
+// Restores the state at `tick` (clamped to the end of the replay). `game` must come from
+// init_game with the replay's board size.
+bool32 seek_replay(Replay *replay, GameState *game, ReplayCursor *cursor, u64 tick) {
+    ReplayHeader *header = &replay->header;
+    if (tick > header->tick_count) tick = header->tick_count;
+
+    u64 low = 0, high = header->keyframe_count - 1;
+    while (low < high) {
+        u64 mid = (low + high + 1) / 2;
+        ByteReader entry = make_reader(replay->data + header->index_offset + mid * REPLAY_INDEX_ENTRY_SIZE, 8);
+        if (read_u64(&entry) <= tick) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    ByteReader entry = make_reader(replay->data + header->index_offset + low * REPLAY_INDEX_ENTRY_SIZE,
+                                   REPLAY_INDEX_ENTRY_SIZE);
+    u64 keyframe_tick = read_u64(&entry);
+    u64 keyframe_offset = read_u64(&entry);
+    if (keyframe_offset >= replay->size) return false;
+
+    ByteReader keyframe = make_reader(replay->data + keyframe_offset, replay->size - keyframe_offset);
+    u64 events_position = read_varint(&keyframe);
+    u64 last_event_tick = read_varint(&keyframe);
+    if (events_position > header->events_size) return false;
+
+    game->food_target = header->food_target;
+    if (!decode_game_state(&keyframe, game)) return false;
+
+    const u8 *events = replay->data + header->events_offset;
+    cursor->events = make_reader(events + events_position, header->events_size - events_position);
+    cursor->tick = keyframe_tick;
+    cursor->next_event_tick = last_event_tick;
+    read_next_event(cursor);
+
+    while (cursor->tick < tick) {
+        step_replay(replay, game, cursor, NULL);
+    }
+
+    return cursor->events.ok;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef _RNG_H_
+#define _RNG_H_
+
+#include "typedefs.h"
+
+// xoshiro256** (Blackman & Vigna). Each game owns one, so runs are reproducible from the
+// seed alone and threads never share generator state.
+struct Rng {
+    u64 s[4];
+};
+
+static u64 rotl64(u64 x, i32 k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static u64 splitmix64(u64 *state) {
+    u64 z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(Rng *rng, u64 seed) {
+    for (i32 i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+static u64 rng_next(Rng *rng) {
+    u64 *s = rng->s;
+    u64 result = rotl64(s[1] * 5, 7) * 9;
+    u64 t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+
+    return result;
+}
+
+// Uniform in [0, bound) via multiply-shift on the top 32 bits.
+static u32 rng_below(Rng *rng, u32 bound) {
+    return (u32)(((rng_next(rng) >> 32) * bound) >> 32);
+}
+
+static void rng_apply_jump(Rng *rng, const u64 jump[4]) {
+    u64 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for (i32 i = 0; i < 4; i++) {
+        for (i32 b = 0; b < 64; b++) {
+            if (jump[i] & (1ull << b)) {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            rng_next(rng);
+        }
+    }
+
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
+
+// Advances by 2^128 draws: 2^128 non-overlapping streams of 2^128 draws each.
+void rng_jump(Rng *rng) {
+    const u64 jump[4] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+    rng_apply_jump(rng, jump);
+}
+
+// Advances by 2^192 draws, for carving out 2^64 groups of jump() streams.
+void rng_long_jump(Rng *rng) {
+    const u64 jump[4] = { 0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull };
+    rng_apply_jump(rng, jump);
+}
+
+// Derives the generator for stream `index` of a seed in O(1), so game N of a run can be
+// reproduced without stepping through games 0..N-1. Use rng_jump when provably disjoint
+// sequences are needed instead.
+Rng rng_split(u64 seed, u64 index) {
+    u64 mix = seed;
+    u64 stream_seed = splitmix64(&mix) ^ (index * 0xd1342543de82ef95ull);
+
+    Rng rng;
+    rng_seed(&rng, stream_seed);
+    return rng;
+}
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef _SHADER_H_
+#define _SHADER_H_
+
+#include "typedefs.h"
+#include "util.h"
+#include "stream_buffer.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <stdio.h>
+#include <string.h>
+
+// A linked program with the locations of its active uniforms, read once at link time so
+// setting a uniform never asks the driver to look a name up. Programs that declare one of the
+// blocks in uniform_blocks get it bound to its binding point as they're linked.
+//
+// FrameData holds what every program shares for a frame: the projection, the cell size and
+// the gap between cells. BodyData is what the body shaders need to draw a snake from its GPU
+// mirror, BoardData what the board pass needs besides its texture. Each is written into the
+// stream buffer and that range bound, once per frame.
+
+#define SHADER_MAX_UNIFORMS 16
+#define SHADER_UNIFORM_NAME_SIZE 32
+#define FRAME_DATA_BINDING 0
+#define BODY_DATA_BINDING 1
+#define BOARD_DATA_BINDING 2
+
+struct ShaderUniform {
+    char name[SHADER_UNIFORM_NAME_SIZE];
+    i32 location;
+};
+
+struct ShaderProgram {
+    u32 id;
+    ShaderUniform uniforms[SHADER_MAX_UNIFORMS];
+    i32 uniform_count;
+};
+
+// std140 layouts of the blocks, see shaders/*.vert.
+struct FrameData {
+    glm::mat4 projection;
+    glm::vec2 cell_size;
+    float gap;
+    float padding;
+};
+static_assert(sizeof(FrameData) == 80, "FrameData must match the std140 block");
+
+struct BodyData {
+    glm::ivec2 board_size;
+    glm::ivec2 view_min;
+    glm::ivec2 view_max;
+    glm::vec2 head_offset;
+    glm::vec2 tail_offset;
+    glm::ivec2 tail_step;
+    glm::vec4 head_color;
+    glm::vec4 body_color;
+    i32 ring_head;
+    i32 ring_mask;
+    i32 body_size;
+    i32 padding;
+};
+static_assert(sizeof(BodyData) == 96, "BodyData must match the std140 block");
+
+struct BoardData {
+    glm::ivec2 board_size;
+    glm::ivec2 view_min;
+    glm::ivec2 view_max;
+    glm::vec2 head_at;
+    glm::vec2 tail_at;
+    glm::ivec2 head_link;
+    glm::ivec2 tail_step;
+    i32 has_head;
+    i32 has_border;
+    glm::vec4 viewport;
+    glm::vec4 head_color;
+    glm::vec4 body_color;
+    glm::vec4 food_color;
+    float subpixel_scale;
+    float padding[3];
+};
+static_assert(sizeof(BoardData) == 144, "BoardData must match the std140 block");
+
+struct UniformBlock {
+    const char *name;
+    u32 binding;
+    u32 size;
+};
+
+static const UniformBlock uniform_blocks[] = {
+    { "FrameData", FRAME_DATA_BINDING, sizeof(FrameData) },
+    { "BodyData", BODY_DATA_BINDING, sizeof(BodyData) },
+    { "BoardData", BOARD_DATA_BINDING, sizeof(BoardData) },
+};
+
+static void reflect_shader_program(ShaderProgram *program) {
+    i32 active = 0;
+    glGetProgramiv(program->id, GL_ACTIVE_UNIFORMS, &active);
+
+    program->uniform_count = 0;
+    for (i32 i = 0; i < active; i++) {
+        char name[SHADER_UNIFORM_NAME_SIZE];
+        i32 size;
+        u32 type;
+        glGetActiveUniform(program->id, (u32)i, sizeof(name), NULL, &size, &type, name);
+
+        // Members of a uniform block have no location and are set through its buffer.
+        i32 location = glGetUniformLocation(program->id, name);
+        if (location < 0) continue;
+
+        if (program->uniform_count == SHADER_MAX_UNIFORMS) {
+            fprintf(stderr, "too many uniforms, %s is not cached\n", name);
+            break;
+        }
+        ShaderUniform *uniform = &program->uniforms[program->uniform_count++];
+        memcpy(uniform->name, name, sizeof(name));
+        uniform->location = location;
+    }
+
+    for (u32 i = 0; i < ARR_SIZE(uniform_blocks); i++) {
+        const UniformBlock *known = &uniform_blocks[i];
+        u32 block = glGetUniformBlockIndex(program->id, known->name);
+        if (block == GL_INVALID_INDEX) continue;
+
+        i32 block_size = 0;
+        glGetActiveUniformBlockiv(program->id, block, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
+        if (block_size != (i32)known->size) {
+            fprintf(stderr, "%s block is %d bytes, expected %u\n", known->name, block_size, known->size);
+        }
+        glUniformBlockBinding(program->id, block, known->binding);
+    }
+}
+
+ShaderProgram load_shader_program(const char *vertex_path, const char *fragment_path) {
+    ShaderProgram program = {};
+    program.id = glCreateProgram();
+    u32 vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    u32 fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+
+    compile_shader_file(vertex_shader, vertex_path);
+    compile_shader_file(fragment_shader, fragment_path);
+
+    glAttachShader(program.id, vertex_shader);
+    glAttachShader(program.id, fragment_shader);
+    glLinkProgram(program.id);
+
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    i32 is_linked;
+    glGetProgramiv(program.id, GL_LINK_STATUS, &is_linked);
+    if (!is_linked) {
+        char error_log[512];
+        glGetProgramInfoLog(program.id, sizeof(error_log), NULL, error_log);
+        fprintf(stderr, "%s + %s link error:\n%s\n", vertex_path, fragment_path, error_log);
+        return program;
+    }
+
+    reflect_shader_program(&program);
+    return program;
+}
+
+// Location of an active uniform, or -1, which glUniform* ignores. Meant for setup: it compares
+// names, so hot paths should keep the location.
+i32 shader_uniform(const ShaderProgram *program, const char *name) {
+    for (i32 i = 0; i < program->uniform_count; i++) {
+        if (!strcmp(program->uniforms[i].name, name)) return program->uniforms[i].location;
+    }
+    return -1;
+}
+
+FrameData make_frame_data(glm::vec2 cell_size, float gap) {
+    FrameData frame = {};
+    frame.cell_size = cell_size;
+    frame.gap = gap;
+    return frame;
+}
+
+// Writes a block into the frame's stream region and binds it there.
+void bind_uniform_block(StreamBuffer *stream, u32 binding, const void *data, u32 size) {
+    i64 offset = stream_write(stream, data, size);
+    if (offset >= 0) glBindBufferRange(GL_UNIFORM_BUFFER, binding, stream->buffer, offset, size);
+}
+
+#endif
@@ -0,0 +1,173 @@
+#version 330 core
+
+// The board in one pass, see board_pass.h. Each fragment tests the quads the instanced
+// renderer draws around it: corners go through the same transform as in cell.vert and
+// bridge.vert and are snapped to the subpixel grid as the rasterizer does, and a pixel centre
+// on a quad's left or bottom edge is inside it, one on its right or top edge isn't. Where quads
+// overlap, what was drawn later wins, as before: the border over bridges, bridges over cells,
+// the head over the body and the body over food. The border and the sliding quads come from
+// board.vert.
+//
+// Along each axis a cell's stretch of the board is the gap towards its lower neighbour, the
+// cell and the gap towards its higher one; these tile the axis, so a pixel centre lies in
+// exactly one of them along x and one along y, and only that cell's texel can cover it. Cells
+// are square, as bridge.vert takes them to be.
+
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec2 cell_size;
+    float gap;
+};
+
+layout (std140) uniform BoardData {
+    ivec2 board_size;
+    ivec2 view_min;
+    ivec2 view_max;
+    vec2 head_at;
+    vec2 tail_at;
+    ivec2 head_link;
+    ivec2 tail_step;
+    int has_head;
+    int has_border;
+    vec4 viewport;
+    vec4 head_color;
+    vec4 body_color;
+    vec4 food_color;
+    float subpixel_scale;
+};
+
+uniform usampler2D board;
+
+flat in vec4 border_lines[4];
+flat in vec4 head_cell;
+flat in vec4 head_bridge;
+flat in vec4 tail_cell;
+flat in vec4 tail_bridge;
+
+out vec4 frag_color;
+
+// BOARD_CELL_* in board_pass.h.
+#define CELL_KIND_MASK 3u
+#define CELL_FOOD 1u
+#define CELL_BODY 2u
+#define LINK_UP 4u
+#define LINK_RIGHT 8u
+#define LINK_DOWN 16u
+#define LINK_LEFT 32u
+
+// Parts of a cell's stretch along an axis.
+#define PART_LOW_GAP 0
+#define PART_CELL 1
+#define PART_HIGH_GAP 2
+
+// What covers a pixel, in draw order.
+#define COVER_NONE 0
+#define COVER_FOOD 1
+#define COVER_BODY 2
+#define COVER_HEAD 3
+#define COVER_BRIDGE 4
+
+// bridge.frag and grid.frag.
+const vec4 BRIDGE_COLOR = vec4(0.2f, 1.0f, 0.0f, 1.0f);
+const vec4 BORDER_COLOR = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+// window_x() and window_y() in board.vert, without the snapping: the corners are snapped to
+// 1 / subpixel_scale, rounding half away from zero, so a pixel centre p, which is never
+// negative, is at or past a corner exactly when the unsnapped corner is below p plus half a
+// step. That takes no rounding here.
+float window_x(float corner, float offset, float shift) {
+    float world = corner + cell_size.x / 2 + cell_size.x * offset + shift;
+    return (projection[0][0] * world + projection[3][0]) * (viewport.z / 2) + (viewport.x + viewport.z / 2);
+}
+
+float window_y(float corner, float offset, float shift) {
+    float world = corner + cell_size.y / 2 + cell_size.y * offset + shift;
+    return -(projection[1][1] * world + projection[3][1]) * (viewport.w / 2) + (viewport.y + viewport.w / 2);
+}
+
+bool is_inside(vec2 pixel, vec4 rect) {
+    return all(greaterThanEqual(pixel, rect.xy)) && all(lessThan(pixel, rect.zw));
+}
+
+// The column a pixel centre at window `x` falls in, and the part of it. Bounds are the bridges'
+// and the cell's corners, so they match the quads exactly.
+ivec2 locate_x(float x) {
+    float bridge = gap / 2, middle = cell_size.x / 2 - gap, shift = cell_size.x / 2 - gap / 2;
+    float device = (x - (viewport.x + viewport.z / 2)) / (viewport.z / 2);
+    int column = int(floor((device - projection[3][0]) / projection[0][0] / cell_size.x));
+    float past = x + 0.5f / subpixel_scale;
+
+    // Mapping back rounds, so the centre may be just across the column's edge.
+    float column_x = float(column);
+    if (window_x(-bridge, column_x, -shift) >= past) column--;
+    else if (window_x(bridge, column_x, shift) < past) column++;
+
+    column_x = float(column);
+    int part = window_x(-middle, column_x, 0.0f) >= past ? PART_LOW_GAP :
+               (window_x(middle, column_x, 0.0f) >= past ? PART_CELL : PART_HIGH_GAP);
+    return ivec2(column, part);
+}
+
+ivec2 locate_y(float y) {
+    float bridge = gap / 2, middle = cell_size.y / 2 - gap, shift = cell_size.y / 2 - gap / 2;
+    float device = (y - (viewport.y + viewport.w / 2)) / (viewport.w / 2);
+    int row = int(floor((-device - projection[3][1]) / projection[1][1] / cell_size.y));
+    float past = y + 0.5f / subpixel_scale;
+
+    float row_y = float(row);
+    if (window_y(-bridge, row_y, -shift) < past) row--;
+    else if (window_y(bridge, row_y, shift) >= past) row++;
+
+    row_y = float(row);
+    int part = window_y(-middle, row_y, 0.0f) < past ? PART_LOW_GAP :
+               (window_y(middle, row_y, 0.0f) < past ? PART_CELL : PART_HIGH_GAP);
+    return ivec2(row, part);
+}
+
+// What a body piece's texel needs for each part of its cell to be covered, by row part and
+// then column part: the piece itself in the middle, its links in the gaps beside it.
+const uint PART_NEEDS[9] = uint[9](0u, LINK_UP, 0u, LINK_LEFT, CELL_BODY, LINK_RIGHT, 0u, LINK_DOWN, 0u);
+
+// What the cells in the texture draw over the pixel. The head slides between cells, so it's
+// drawn from head_at instead.
+int cover_board(vec2 pixel) {
+    ivec2 column = locate_x(pixel.x);
+    ivec2 row = locate_y(pixel.y);
+    ivec2 at = ivec2(column.x, row.x);
+    if (any(lessThan(at, view_min)) || any(greaterThan(at, view_max))) return COVER_NONE;
+
+    // A view starts less than a board before cell 0 and spans at most one, so one wrap does.
+    ivec2 pos = at + board_size * (ivec2(lessThan(at, ivec2(0))) - ivec2(greaterThanEqual(at, board_size)));
+    uint cell = texelFetch(board, pos, 0).r;
+    uint kind = cell & CELL_KIND_MASK;
+    if (kind == CELL_FOOD) return column.y == PART_CELL && row.y == PART_CELL ? COVER_FOOD : COVER_NONE;
+    if (kind != CELL_BODY) return COVER_NONE;
+
+    uint needs = PART_NEEDS[row.y * 3 + column.y];
+    if (needs == 0u || (cell & needs) != needs) return COVER_NONE;
+    return needs == CELL_BODY ? COVER_BODY : COVER_BRIDGE;
+}
+
+bool on_border(vec2 pixel) {
+    return is_inside(pixel, border_lines[0]) || is_inside(pixel, border_lines[1]) || is_inside(pixel, border_lines[2]) ||
+           is_inside(pixel, border_lines[3]);
+}
+
+void main() {
+    vec2 pixel = gl_FragCoord.xy;
+    if (has_border != 0 && on_border(pixel)) {
+        frag_color = BORDER_COLOR;
+        return;
+    }
+
+    int cover = cover_board(pixel);
+    if (is_inside(pixel, head_bridge) || is_inside(pixel, tail_bridge)) cover = COVER_BRIDGE;
+    if (is_inside(pixel, head_cell)) cover = max(cover, COVER_HEAD);
+    if (is_inside(pixel, tail_cell)) cover = max(cover, COVER_BODY);
+
+    if (cover == COVER_NONE) discard;
+    if (cover == COVER_FOOD) frag_color = food_color;
+    if (cover == COVER_BODY) frag_color = body_color;
+    if (cover == COVER_HEAD) frag_color = head_color;
+    if (cover == COVER_BRIDGE) frag_color = BRIDGE_COLOR;
+}
@@ -0,0 +1,175 @@
+#version 330 core
+
+// One triangle over the whole viewport; board.frag does the rest. What's the same for every
+// pixel is worked out here and handed on flat: the border's lines, and the quads of the head
+// and of the cell the tail tip left, which don't sit on whole cells while they slide. Each is a
+// rectangle of the pixel centres it covers, from .xy up to, but not including, .zw.
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec2 cell_size;
+    float gap;
+};
+
+layout (std140) uniform BoardData {
+    ivec2 board_size;
+    ivec2 view_min;
+    ivec2 view_max;
+    vec2 head_at;
+    vec2 tail_at;
+    ivec2 head_link;
+    ivec2 tail_step;
+    int has_head;
+    int has_border;
+    vec4 viewport;
+    vec4 head_color;
+    vec4 body_color;
+    vec4 food_color;
+    float subpixel_scale;
+};
+
+// grid.h's border, in normalized device coordinates.
+#define BORDER_LIMIT 0.999f
+
+flat out vec4 border_lines[4];
+flat out vec4 head_cell;
+flat out vec4 head_bridge;
+flat out vec4 tail_cell;
+flat out vec4 tail_bridge;
+
+// Rounded half away from zero.
+float snap(float position) {
+    return sign(position) * floor(abs(position) * subpixel_scale + 0.5f) / subpixel_scale;
+}
+
+// Where the vertex shaders put a quad's corner along each axis: `corner` from the middle of the
+// cell at `offset`, moved by `shift`, summed in the same order. The projection is orthographic,
+// so each axis only needs its own row of it. Window y runs against the world's.
+float window_x(float corner, float offset, float shift) {
+    float world = corner + cell_size.x / 2 + cell_size.x * offset + shift;
+    return snap((projection[0][0] * world + projection[3][0]) * (viewport.z / 2) + (viewport.x + viewport.z / 2));
+}
+
+float window_y(float corner, float offset, float shift) {
+    float world = corner + cell_size.y / 2 + cell_size.y * offset + shift;
+    return snap(-(projection[1][1] * world + projection[3][1]) * (viewport.w / 2) + (viewport.y + viewport.w / 2));
+}
+
+// The quad of cell.vert at `offset`.
+vec4 cell_rect(vec2 offset) {
+    float position = cell_size.x / 2 - gap;
+    vec2 a = vec2(window_x(-position, offset.x, 0.0f), window_y(-position, offset.y, 0.0f));
+    vec2 b = vec2(window_x(position, offset.x, 0.0f), window_y(position, offset.y, 0.0f));
+    return vec4(min(a, b), max(a, b));
+}
+
+// The quad of bridge.vert hanging off the cell at `cell_position`.
+vec4 bridge_rect(vec2 cell_position, vec2 direction) {
+    vec2 position = vec2(cell_size.x / 2 - gap, gap / 2);
+    vec2 corner = direction.x == 0.0f ? position : position.yx;
+    vec2 shift = (cell_size / 2 - gap / 2) * direction;
+    vec2 a = vec2(window_x(-corner.x, cell_position.x, shift.x), window_y(-corner.y, cell_position.y, shift.y));
+    vec2 b = vec2(window_x(corner.x, cell_position.x, shift.x), window_y(corner.y, cell_position.y, shift.y));
+    return vec4(min(a, b), max(a, b));
+}
+
+vec2 viewport_transform(vec2 device) {
+    return device * (viewport.zw / 2) + (viewport.xy + viewport.zw / 2);
+}
+
+float sign_of(float value) {
+    return value < 0.0f ? -1.0f : 1.0f;
+}
+
+// The pixel centres the line from `v1` to `v2` lights, as a rectangle from .xy up to, but
+// not including, .zw. Each end is kept or dropped by the diamond-exit rule, and what's between
+// them is a one pixel wide quad, the way llvmpipe sets lines up; a GPU may light a pixel more or
+// less at the ends. Only the border's axis-aligned lines come through here.
+vec4 line_span(vec2 v1, vec2 v2) {
+    vec2 delta = v1 - v2;
+    vec2 diff1 = fract(v1) - 0.5f;
+    vec2 diff2 = fract(v2) - 0.5f;
+    bool is_x_major = abs(delta.x) >= abs(delta.y);
+
+    // The line in (major, minor) coordinates. The y-major tests are the x-major ones mirrored.
+    vec2 d = is_x_major ? delta : delta.yx;
+    vec2 p1 = is_x_major ? v1 : v1.yx, p2 = is_x_major ? v2 : v2.yx;
+    vec2 e1 = is_x_major ? diff1 : diff1.yx, e2 = is_x_major ? diff2 : diff2.yx;
+    float flip = is_x_major ? 1.0f : -1.0f;
+    float slope = d.y / d.x;
+
+    if (e2.y == -0.5f && d.y < 0.0f) e2.y = 0.5f;
+
+    bool draws_start, draws_end;
+    if (abs(e1.x) + abs(e1.y) < 0.5f) {
+        draws_start = true;
+    } else if (sign_of(flip * e1.x) == sign_of(-flip * d.x)) {
+        draws_start = false;
+    } else if (sign_of(-flip * e1.y) != sign_of(flip * d.y)) {
+        draws_start = true;
+    } else {
+        float intersect = fract(p1.y) + e1.x * slope;
+        draws_start = intersect < 1.0f && intersect > 0.0f;
+    }
+
+    if (abs(e2.x) + abs(e2.y) < 0.5f) {
+        draws_end = false;
+    } else if (sign_of(flip * e2.x) != sign_of(-flip * d.x)) {
+        draws_end = false;
+    } else if (sign_of(-flip * e2.y) == sign_of(flip * d.y)) {
+        draws_end = true;
+    } else {
+        float intersect = fract(p2.y) + e2.x * slope;
+        draws_end = intersect < 1.0f && (is_x_major ? intersect > 0.0f : intersect >= 0.0f);
+    }
+
+    bool will_draw_start = sign_of(-flip * e1.x) != sign_of(flip * d.x);
+    bool will_draw_end = sign_of(flip * e2.x) == sign_of(-flip * d.x) || e2.x == 0.0f;
+
+    // Ordered so the line runs towards increasing x, or decreasing y.
+    vec2 start_offset = vec2(0.0f), end_offset = vec2(0.0f);
+    if (flip * d.x < 0.0f) {
+        vec2 swap = p1;
+        p1 = p2;
+        p2 = swap;
+        if (will_draw_start != draws_start) end_offset.x = -e1.x - 0.5f * flip;
+        if (will_draw_end != draws_end) start_offset.x = -e2.x - 0.5f * flip;
+    } else {
+        if (will_draw_start != draws_start) start_offset.x = -e1.x + 0.5f * flip;
+        if (will_draw_end != draws_end) end_offset.x = -e2.x + 0.5f * flip;
+    }
+    start_offset.y = start_offset.x * slope;
+    end_offset.y = end_offset.x * slope;
+
+    // The quad's corners are snapped; pixel centres sit half a pixel past the integers it's
+    // set up on.
+    vec2 from = vec2(snap(p1.x + start_offset.x - 0.5f), snap(p1.y + start_offset.y - 0.5f));
+    vec2 to = vec2(snap(p2.x + end_offset.x - 0.5f), snap(p2.y + end_offset.y - 0.5f));
+    vec2 low = vec2(min(from.x, to.x) + 0.5f, from.y);
+    vec2 high = vec2(max(from.x, to.x) + 0.5f, from.y + 1.0f);
+    return is_x_major ? vec4(low, high) : vec4(low.yx, high.yx);
+}
+
+void main() {
+    vec2 top_left = viewport_transform(vec2(-BORDER_LIMIT, BORDER_LIMIT));
+    vec2 top_right = viewport_transform(vec2(BORDER_LIMIT, BORDER_LIMIT));
+    vec2 bottom_left = viewport_transform(vec2(-BORDER_LIMIT, -BORDER_LIMIT));
+    vec2 bottom_right = viewport_transform(vec2(BORDER_LIMIT, -BORDER_LIMIT));
+    border_lines[0] = line_span(top_left, top_right);
+    border_lines[1] = line_span(top_right, bottom_right);
+    border_lines[2] = line_span(bottom_right, bottom_left);
+    border_lines[3] = line_span(bottom_left, top_left);
+
+    // Empty rectangles for what isn't drawn.
+    head_cell = head_bridge = tail_cell = tail_bridge = vec4(0.0f);
+    if (has_head != 0) {
+        head_cell = cell_rect(head_at);
+        if (head_link != ivec2(0)) head_bridge = bridge_rect(head_at, vec2(head_link));
+    }
+    if (tail_step != ivec2(0)) {
+        tail_cell = cell_rect(tail_at);
+        tail_bridge = bridge_rect(tail_at, vec2(tail_step));
+    }
+
+    vec2 corner = vec2(float((gl_VertexID & 1) * 4 - 1), float((gl_VertexID >> 1) * 4 - 1));
+    gl_Position = vec4(corner, 1.0f, 1.0f);
+}
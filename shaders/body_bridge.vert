@@ -0,0 +1,68 @@
+#version 330 core
+
+// Bridges of a snake mirrored in `body`, see body_cell.vert: instances 2i and 2i + 1 join piece
+// i to the pieces before and after it, and instance 2 * body_size trails the tail tip's old cell
+// (none when `tail_step` is zero).
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec2 cell_size;
+    float gap;
+};
+
+layout (std140) uniform BodyData {
+    ivec2 board_size;
+    ivec2 view_min;
+    ivec2 view_max;
+    vec2 head_offset;
+    vec2 tail_offset;
+    ivec2 tail_step;
+    vec4 head_color;
+    vec4 body_color;
+    int ring_head;
+    int ring_mask;
+    int body_size;
+};
+
+uniform isamplerBuffer body;
+
+ivec2 body_piece(int piece) {
+    return texelFetch(body, (ring_head + piece) & ring_mask).xy;
+}
+
+// board_wrap_delta() in board.h.
+ivec2 wrap_delta(ivec2 delta) {
+    ivec2 half_board = board_size / 2;
+    delta -= board_size * ivec2(greaterThan(delta, half_board));
+    delta += board_size * ivec2(lessThan(delta, -half_board));
+    return delta;
+}
+
+// quad_corner() in cell.vert.
+vec2 quad_corner() {
+    return vec2(float(gl_VertexID >> 1) * 2.0f - 1.0f, 1.0f - float(gl_VertexID & 1) * 2.0f);
+}
+
+void main() {
+    bool is_trailing = gl_InstanceID == 2 * body_size;
+    int piece = is_trailing ? body_size - 1 : gl_InstanceID / 2;
+    int neighbour = (gl_InstanceID & 1) == 0 ? piece - 1 : piece + 1;
+
+    ivec2 pos = body_piece(piece);
+    ivec2 at = view_min + (pos - view_min + board_size) % board_size;
+    vec2 direction = is_trailing ? vec2(tail_step) : vec2(wrap_delta(body_piece(neighbour) - pos));
+
+    vec2 offset = vec2(at);
+    if (piece == 0) offset += head_offset;
+    if (is_trailing) offset += tail_offset;
+
+    bool has_neighbour = is_trailing ? tail_step != ivec2(0) : neighbour >= 0 && neighbour < body_size;
+    if (any(greaterThan(at, view_max)) || !has_neighbour) {
+        gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
+        return;
+    }
+
+    vec2 position = quad_corner() * vec2(cell_size.x / 2 - gap, gap / 2);
+    vec2 corner = direction.x == 0.0f ? position : position.yx;
+    vec2 bridge_offset = (cell_size / 2 - gap / 2) * direction;
+    gl_Position = projection * vec4(corner + cell_size / 2 + cell_size * offset + bridge_offset, 1.0f, 1.0f) * vec4(1.0f, -1.0f, 1.0f, 1.0f);
+}
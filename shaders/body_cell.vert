@@ -0,0 +1,54 @@
+#version 330 core
+
+// Cells of a snake whose body is mirrored in `body` (body_mirror.h), drawn from the tail up so
+// the head covers the piece it's sliding off: instance 0 is the cell the tail tip just left,
+// sliding out behind it (none when `tail_step` is zero), and instance `body_size` - i is piece i
+// from the head. Pieces outside the view are moved past the clip volume.
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec2 cell_size;
+    float gap;
+};
+
+layout (std140) uniform BodyData {
+    ivec2 board_size;
+    ivec2 view_min;
+    ivec2 view_max;
+    vec2 head_offset;
+    vec2 tail_offset;
+    ivec2 tail_step;
+    vec4 head_color;
+    vec4 body_color;
+    int ring_head;
+    int ring_mask;
+    int body_size;
+};
+
+uniform isamplerBuffer body;
+
+out vec3 cell_color;
+
+// quad_corner() in cell.vert.
+vec2 quad_corner() {
+    return vec2(float(gl_VertexID >> 1) * 2.0f - 1.0f, 1.0f - float(gl_VertexID & 1) * 2.0f);
+}
+
+void main() {
+    int instance = body_size - gl_InstanceID;
+    int piece = min(instance, body_size - 1);
+    ivec2 pos = texelFetch(body, (ring_head + piece) & ring_mask).xy;
+    // The view starts less than a board before any cell, so the sum is never negative.
+    ivec2 at = view_min + (pos - view_min + board_size) % board_size;
+
+    vec2 offset = vec2(at);
+    if (instance == 0) offset += head_offset;
+    if (instance == body_size) offset += tail_offset;
+
+    cell_color = instance == 0 ? head_color.rgb : body_color.rgb;
+    if (any(greaterThan(at, view_max)) || (instance == body_size && tail_step == ivec2(0))) {
+        gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f);
+        return;
+    }
+    vec2 position = quad_corner() * (cell_size / 2 - gap);
+    gl_Position = projection * vec4(position + cell_size / 2 + cell_size * offset, 1.0f, 1.0f) * vec4(1.0f, -1.0f, 1.0f, 1.0f);
+}
@@ -1,12 +1,24 @@
 #version 330 core
 
-layout (location = 0) in vec2 position;
+// The base quad spans the gap to a neighbour above or below; it's turned on its side for
+// neighbours to the left or right.
+layout (location = 0) in vec2 cell_position;
+layout (location = 1) in vec2 direction;
 
-uniform vec2 cell_size;
-uniform ivec2 cell_position;
-uniform vec2 offset;
-uniform mat4 projection;
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec2 cell_size;
+    float gap;
+};
+
+// quad_corner() in cell.vert.
+vec2 quad_corner() {
+    return vec2(float(gl_VertexID >> 1) * 2.0f - 1.0f, 1.0f - float(gl_VertexID & 1) * 2.0f);
+}
 
 void main() {
-    gl_Position = projection * vec4(position + cell_size / 2 + cell_size * cell_position + offset, 1.0f, 1.0f) * vec4(1.0f, -1.0f, 1.0f, 1.0f);
+    vec2 position = quad_corner() * vec2(cell_size.x / 2 - gap, gap / 2);
+    vec2 corner = direction.x == 0.0f ? position : position.yx;
+    vec2 offset = (cell_size / 2 - gap / 2) * direction;
+    gl_Position = projection * vec4(corner + cell_size / 2 + cell_size * cell_position + offset, 1.0f, 1.0f) * vec4(1.0f, -1.0f, 1.0f, 1.0f);
 }
@@ -1,9 +1,9 @@
 #version 330 core
 
-out vec4 frag_color;
+in vec3 cell_color;
 
-uniform vec3 color;
+out vec4 frag_color;
 
 void main() {
-	frag_color = vec4(color, 1.0f);
-}
\ No newline at end of file
+	frag_color = vec4(cell_color, 1.0f);
+}
@@ -1,11 +1,23 @@
 #version 330 core
 
-layout (location = 0) in vec2 position;
+layout (location = 0) in vec2 offset;
+layout (location = 1) in vec3 color;
 
-uniform vec2 cell_size;
-uniform ivec2 offset;
-uniform mat4 projection;
+layout (std140) uniform FrameData {
+    mat4 projection;
+    vec2 cell_size;
+    float gap;
+};
+
+out vec3 cell_color;
+
+// The quad's corners as a triangle strip, from the top left down and across.
+vec2 quad_corner() {
+    return vec2(float(gl_VertexID >> 1) * 2.0f - 1.0f, 1.0f - float(gl_VertexID & 1) * 2.0f);
+}
 
 void main() {
+    vec2 position = quad_corner() * (cell_size / 2 - gap);
+    cell_color = color;
     gl_Position = projection * vec4(position + cell_size / 2 + cell_size * offset, 1.0f, 1.0f) * vec4(1.0f, -1.0f, 1.0f, 1.0f);
 }
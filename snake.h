@@ -2,205 +2,244 @@
 #define _SNAKE_H_
 
 #include "typedefs.h"
+#include "game.h"
+#include "arena.h"
 #include "cell.h"
+#include "bridge.h"
+#include "camera.h"
+#include "instance_batch.h"
+#include "body.h"
+#include "body_mirror.h"
 
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
-#include <deque>
 #include <stdlib.h>
 #include <string.h>
 
-struct TailPiece {
-    glm::ivec2 pos;
-};
-
-struct SnakeData {
-    std::deque<TailPiece> tail;
-    glm::ivec2 velocity;
-    bool32 should_grow;
-};
-
-struct TurnsQueue {
-    i32 size;
-    i32 data[3];
-};
+i32 key_to_direction(i32 key) {
+    switch (key) {
+        #define KEY_TO_DIRECTION(key, dir) case key: return dir
+        KEY_TO_DIRECTION(GLFW_KEY_UP, DIRECTION_UP);
+        KEY_TO_DIRECTION(GLFW_KEY_RIGHT, DIRECTION_RIGHT);
+        KEY_TO_DIRECTION(GLFW_KEY_DOWN, DIRECTION_DOWN);
+        KEY_TO_DIRECTION(GLFW_KEY_LEFT, DIRECTION_LEFT);
+    }
+    return DIRECTION_NONE;
+}
 
-struct GameState {
-    SnakeData snake;
-    TurnsQueue turns_queue;
-    i32 map[CELL_COUNT][CELL_COUNT];
-    bool32 paused;
-    bool32 is_over;
-    i32 cells_left;
-    glm::ivec2 food_pos;
+#define FOOD_COLOR glm::vec3(1.0f, 1.0f, 0.0f)
+
+// How the head and tail tip moved on the last tick, so frames between ticks can slide them
+// from their previous cells. Only the ends move on screen: every other piece takes the cell
+// the piece ahead of it just left.
+struct SnakeMotion {
+    glm::ivec2 prev_head;
+    glm::ivec2 prev_tail;
+    glm::ivec2 head_step;
+    glm::ivec2 tail_step;
+    bool32 has_tail_moved;
+    bool32 is_valid;
 };
 
-static void map_set(i32 map[CELL_COUNT][CELL_COUNT], glm::ivec2 pos, i32 value) {
-    map[pos.y][pos.x] = value;
+void begin_snake_motion(SnakeMotion *motion, TailRing *tail) {
+    motion->prev_head = tail_front(tail)->pos;
+    motion->prev_tail = tail_back(tail)->pos;
 }
 
-static i32 map_at(i32 map[CELL_COUNT][CELL_COUNT], glm::ivec2 pos) {
-    return map[pos.y][pos.x];
+// `result` is what the tick did; a death restarts the game, so there is nothing to slide.
+void end_snake_motion(SnakeMotion *motion, const Board *board, TailRing *tail, TickResult result) {
+    motion->head_step = board_wrap_delta(board, tail_front(tail)->pos - motion->prev_head);
+    motion->tail_step = board_wrap_delta(board, tail_back(tail)->pos - motion->prev_tail);
+    motion->has_tail_moved = motion->tail_step != glm::ivec2(0, 0);
+    motion->is_valid = result != TICK_DIED && abs(motion->head_step.x) + abs(motion->head_step.y) == 1;
 }
 
-void push_queue(TurnsQueue *queue, i32 key) {
-    if (queue->size < ARR_SIZE(queue->data)) {
-        queue->data[queue->size++] = key;
-    }
+// Where the head is drawn `alpha` of the way through the next tick, in cells.
+glm::vec2 snake_motion_head(const SnakeMotion *motion, TailRing *tail, float alpha) {
+    glm::vec2 head = glm::vec2(tail_front(tail)->pos);
+    if (!motion || !motion->is_valid) return head;
+    return head - glm::vec2(motion->head_step) * (1.0f - alpha);
 }
 
-static i32 pop_queue(TurnsQueue *queue) {
-    i32 result = 0;
-
-    if (queue->size > 0) {
-        result = queue->data[0];
-        for (size_t i = 1; i < queue->size; i++) {
-            queue->data[i - 1] = queue->data[i];
-        }
-        queue->size--;
-    }
+// Cell -> ring slot of the body piece on it, so drawing can start from the visible cells
+// instead of walking the whole body. Entries are checked against the ring before use; a stale
+// one (after a restart or a load) triggers a rebuild.
+struct BodyIndex {
+    u32 *slot;
+    u32 cell_count;
+};
 
-    return result;
+void init_body_index(BodyIndex *index, u32 cell_count) {
+    index->cell_count = cell_count;
+    index->slot = (u32 *)malloc(cell_count * sizeof(u32));
+    memset(index->slot, 0xff, cell_count * sizeof(u32));
 }
 
-static void push_new_head(std::deque<TailPiece> *tail, i32 map[CELL_COUNT][CELL_COUNT], glm::ivec2 pos) {
-    tail->push_front({ pos });
-    map_set(map, pos, 1);
+void free_body_index(BodyIndex *index) {
+    free(index->slot);
+    index->slot = NULL;
+    index->cell_count = 0;
 }
 
-static void pop_tail(std::deque<TailPiece> *tail, i32 map[CELL_COUNT][CELL_COUNT]) {
-    glm::ivec2 tail_tip_pos = tail->back().pos;
-    tail->pop_back();
-    map_set(map, tail_tip_pos, 0);
+static void rebuild_body_index(BodyIndex *index, const Board *board, TailRing *tail) {
+    for (u32 i = 0; i < tail->size; i++) {
+        index->slot[board_index(board, tail_at(tail, i)->pos)] = (tail->head + i) & tail->mask;
+    }
 }
 
-static bool32 can_change_direction(glm::ivec2 old_velocity, glm::ivec2 new_velocity) {
-    glm::ivec2 sum = old_velocity + new_velocity;
-    return sum.x && sum.y;
+// Indexes the pieces pushed since the last call: they sit at the front, so this walks from the
+// head until it meets a piece that is already indexed.
+void update_body_index(BodyIndex *index, const Board *board, TailRing *tail) {
+    for (u32 i = 0; i < tail->size; i++) {
+        u32 slot = (tail->head + i) & tail->mask;
+        u32 cell = board_index(board, tail->data[slot].pos);
+        if (index->slot[cell] == slot) break;
+        index->slot[cell] = slot;
+    }
 }
 
-static glm::ivec2 gen_random_food_pos(i32 map[CELL_COUNT][CELL_COUNT]) {
-    bool32 overlaps;
-    glm::ivec2 new_food_pos;
+// Position along the body (0 = head) of the piece on board cell `pos`, or -1.
+static i32 find_body_piece(BodyIndex *index, const Board *board, TailRing *tail, glm::ivec2 pos) {
+    for (i32 attempt = 0; attempt < 2; attempt++) {
+        u32 slot = index->slot[board_index(board, pos)];
+        u32 offset = (slot - tail->head) & tail->mask;
+        if (slot <= tail->mask && offset < tail->size && tail->data[slot].pos == pos) return (i32)offset;
+        rebuild_body_index(index, board, tail);
+    }
+    return -1;
+}
 
-    do {
-        overlaps = false;
-        new_food_pos = { rand() % CELL_COUNT, rand() % CELL_COUNT };
-        overlaps = map_at(map, new_food_pos);
-    } while (overlaps);
+// Adds the piece at `offset` along `tail` at view coordinate `at`, with bridges to its
+// neighbours along the body.
+static void push_body_piece(InstanceBatch *batch, const Board *board, TailRing *tail, u32 offset, glm::vec2 at,
+                            glm::vec3 color) {
+    #define BRIDGE_DIRECTION(from, to) board_wrap_delta(board, (to) - (from))
 
-    return new_food_pos;
+    glm::ivec2 pos = tail_at(tail, offset)->pos;
+    push_cell(batch, at, color);
+    if (offset > 0) push_bridge(batch, at, BRIDGE_DIRECTION(pos, tail_at(tail, offset - 1)->pos));
+    if (offset + 1 < tail->size) push_bridge(batch, at, BRIDGE_DIRECTION(pos, tail_at(tail, offset + 1)->pos));
 }
 
-static void turn_snake(SnakeData *snake, TurnsQueue *queue) {
-    i32 new_dir = pop_queue(queue);
+// Adds only the pieces inside `view`, so the cost follows the view size, not the snake length.
+// With a `motion`, the head and tail tip are placed `alpha` of the way from their previous cells.
+void push_snake(InstanceBatch *batch, const Board *board, OccupancyGrid *map, TailRing *tail, BodyIndex *index,
+                const CameraView *view, glm::vec3 color, const SnakeMotion *motion, float alpha) {
+    update_body_index(index, board, tail);
+    glm::vec3 body_color = glm::vec3(0.7f * color.x, 0.7f * color.y, 0.7f * color.z);
+
+    bool32 is_moving = motion && motion->is_valid;
+    glm::ivec2 tail_at_view;
+    if (is_moving && motion->has_tail_moved && camera_unwrap(view, board, tail_back(tail)->pos, &tail_at_view)) {
+        // The cell the tail tip left, shrinking away behind the new tip.
+        glm::vec2 at = glm::vec2(tail_at_view) - glm::vec2(motion->tail_step) * (1.0f - alpha);
+        push_cell(batch, at, body_color);
+        push_bridge(batch, at, motion->tail_step);
+    }
 
-    if (new_dir) {
-        glm::ivec2 new_velocity;
-        switch (new_dir) {
-            #define KEY_TO_VELOCITY(key, x, y) case key: new_velocity = {x, y}; break
-            KEY_TO_VELOCITY(GLFW_KEY_UP, 0, -1);
-            KEY_TO_VELOCITY(GLFW_KEY_RIGHT, 1, 0);
-            KEY_TO_VELOCITY(GLFW_KEY_DOWN, 0, 1);
-            KEY_TO_VELOCITY(GLFW_KEY_LEFT, -1, 0);
-        }
+    for (i32 y = view->min.y; y <= view->max.y; y++) {
+        for (i32 x = view->min.x; x <= view->max.x; x++) {
+            glm::ivec2 pos = camera_wrap(board, { x, y });
+            if (!map_at(map, board_index(board, pos))) continue;
 
-        if (can_change_direction(snake->velocity, new_velocity)) {
-            snake->velocity = new_velocity;
+            i32 offset = find_body_piece(index, board, tail, pos);
+            if (offset <= 0) continue;
+            push_body_piece(batch, board, tail, (u32)offset, glm::vec2((float)x, (float)y), body_color);
         }
     }
-}
 
-void restart_game(GameState *game) {
-    const glm::ivec2 initial_positions[] = {
-        {3, 1}, {2, 1}, {1, 1}
-    };
-    
-    game->is_over = false;
-    game->paused = false;
-    game->turns_queue.size = 0;
-    game->cells_left = CELL_COUNT * CELL_COUNT - ARR_SIZE(initial_positions);
-    game->snake.tail.clear();
-    memset(game->map, 0, sizeof(game->map));
-
-    for (i32 i = 0; i < ARR_SIZE(initial_positions); i++) {
-        game->snake.tail.push_back({ initial_positions[i] });
-        map_set(game->map, initial_positions[i], 1);
+    // The head goes last so that while it slides in, it covers the piece it's leaving.
+    glm::ivec2 head_at_view;
+    if (tail->size && camera_unwrap(view, board, tail_at(tail, 0)->pos, &head_at_view)) {
+        glm::vec2 at = glm::vec2(head_at_view);
+        if (is_moving) at -= glm::vec2(motion->head_step) * (1.0f - alpha);
+        push_body_piece(batch, board, tail, 0, at, color);
     }
-
-    game->snake.should_grow = false;
-    game->snake.velocity = { 1, 0 };
-
-    game->food_pos = gen_random_food_pos(game->map);
 }
 
-void update_snake(GameState *game) {
-    SnakeData *snake = &game->snake;
-    TurnsQueue *queue = &game->turns_queue;
-    turn_snake(snake, queue);
-
-    if (snake->should_grow) {
-        snake->should_grow = false;
-
-        if (--game->cells_left <= 0) {
-            game->paused = true;
-            game->is_over = true;
-        }
-    } else {
-        pop_tail(&snake->tail, game->map);
+static BodyData make_body_data(const Board *board, TailRing *tail, const CameraView *view, glm::vec3 color,
+                               const SnakeMotion *motion, float alpha) {
+    BodyData body = {};
+    body.board_size = glm::ivec2(board->width, board->height);
+    body.view_min = view->min;
+    body.view_max = view->max;
+    if (motion && motion->is_valid) {
+        body.head_offset = -glm::vec2(motion->head_step) * (1.0f - alpha);
+        body.tail_offset = -glm::vec2(motion->tail_step) * (1.0f - alpha);
+        body.tail_step = motion->tail_step;
     }
+    body.head_color = glm::vec4(color, 1.0f);
+    body.body_color = glm::vec4(0.7f * color.x, 0.7f * color.y, 0.7f * color.z, 1.0f);
+    body.ring_head = (i32)tail->head;
+    body.ring_mask = (i32)tail->mask;
+    body.body_size = (i32)tail->size;
+    return body;
+}
 
-    glm::ivec2 new_head_pos = snake->tail.front().pos + snake->velocity;
+// Drawing from the mirror runs the vertex shaders over every piece, so it only pays off while
+// the body is no longer than the view is cells; past that, push_snake's walk over the view is
+// cheaper.
+bool32 body_fits_view(const TailRing *tail, const CameraView *view) {
+    u64 view_cells = (u64)(view->max.x - view->min.x + 1) * (u64)(view->max.y - view->min.y + 1);
+    return tail->size <= view_cells;
+}
 
-    if (new_head_pos.x < 0)              new_head_pos.x = CELL_COUNT - 1;
-    if (new_head_pos.y < 0)              new_head_pos.y = CELL_COUNT - 1;
-    if (new_head_pos.x > CELL_COUNT - 1) new_head_pos.x = 0;
-    if (new_head_pos.y > CELL_COUNT - 1) new_head_pos.y = 0;
+// Draws the whole body from its GPU mirror, which must be synced with `tail`. The CPU side
+// costs the same at any length; the vertex shaders drop the pieces outside the view. Writes
+// BodyData into the stream, so the frame has to reserve room for it.
+void render_snake_body(ObjectData *cell, ObjectData *bridge, BodyMirror *mirror, StreamBuffer *stream,
+                       const Board *board, TailRing *tail, const CameraView *view, glm::vec3 color,
+                       const SnakeMotion *motion, float alpha) {
+    if (!tail->size) return;
 
-    if (!map_at(game->map, new_head_pos)) {
-        push_new_head(&snake->tail, game->map, new_head_pos);
-    } else {
-        restart_game(game);
-    }
+    BodyData body = make_body_data(board, tail, view, color, motion, alpha);
+    bind_uniform_block(stream, BODY_DATA_BINDING, &body, sizeof(BodyData));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, mirror->texture);
 
-    if (!game->is_over && new_head_pos == game->food_pos) {
-        game->food_pos = gen_random_food_pos(game->map);
-        snake->should_grow = true;
-    }
-}
+    glUseProgram(cell->shader.id);
+    glBindVertexArray(cell->vao);
+    glDrawArraysInstanced(cell->primitive, 0, cell->vertex_count, (GLsizei)(tail->size + 1));
 
-void render_cell(ObjectData *cell, i32 x, i32 y) {
-    glUseProgram(cell->shader);
-    glUniform2i(glGetUniformLocation(cell->shader, "offset"), x, y);
+    glUseProgram(bridge->shader.id);
+    glBindVertexArray(bridge->vao);
+    glDrawArraysInstanced(bridge->primitive, 0, bridge->vertex_count, (GLsizei)(2 * tail->size + 1));
 
-    glBindVertexArray(cell->vao);
-    glDrawElements(cell->primitive, cell->vertex_count, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glUseProgram(0);
 }
 
-void render_food(ObjectData *cell, glm::ivec2 food_pos) {
-    glUseProgram(cell->shader);
-    glUniform3f(glGetUniformLocation(cell->shader, "color"), 1.0f, 1.0f, 0.0f);
-    render_cell(cell, food_pos.x, food_pos.y);
+void push_visible_food(InstanceBatch *batch, const Board *board, const CameraView *view, glm::ivec2 food_pos) {
+    glm::ivec2 at;
+    if (camera_unwrap(view, board, food_pos, &at)) push_cell(batch, glm::vec2(at), FOOD_COLOR);
 }
 
-void render_snake(std::deque<TailPiece> *tail, ObjectData *cell, ObjectData *bridge, glm::vec2 cell_size) {
-    glUseProgram(cell->shader);
-    auto head = tail->begin();
-    glUniform3f(glGetUniformLocation(cell->shader, "color"), 1.0f, 0.0f, 0.0f);
-    render_cell(cell, head->pos.x, head->pos.y);
-    glUniform3f(glGetUniformLocation(cell->shader, "color"), 0.7f, 0.0f, 0.0f);
-    render_bridge(bridge, cell_size, head->pos, (head + 1)->pos - head->pos);
-
-    for (auto it = tail->begin() + 1; it != tail->end() - 1; ++it) {
-        render_cell(cell, it->pos.x, it->pos.y);
-        render_bridge(bridge, cell_size, it->pos, (it - 1)->pos - it->pos);
-        render_bridge(bridge, cell_size, it->pos, (it + 1)->pos - it->pos);
+// The player's snake is red like in the single-snake game, computer snakes are blue.
+void push_arena(InstanceBatch *batch, Arena *arena, const CameraView *view) {
+    const Board *board = &arena->board;
+    const glm::vec3 player_color = glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 ai_color = glm::vec3(0.2f, 0.5f, 1.0f);
+
+    for (i32 y = view->min.y; y <= view->max.y; y++) {
+        for (i32 x = view->min.x; x <= view->max.x; x++) {
+            u32 index = board_index(board, camera_wrap(board, { x, y }));
+            u32 owner = arena->owner[index];
+            if (owner == ARENA_FREE) continue;
+            if (owner == ARENA_FOOD) {
+                push_cell(batch, glm::vec2((float)x, (float)y), FOOD_COLOR);
+                continue;
+            }
+
+            TailRing *tail = &arena->snakes[owner - 1].tail;
+            u32 offset = (arena->slot[index] - tail->head) & tail->mask;
+            glm::vec3 color = owner == 1 ? player_color : ai_color;
+            if (offset > 0) color = glm::vec3(0.7f * color.x, 0.7f * color.y, 0.7f * color.z);
+
+            push_body_piece(batch, board, tail, offset, glm::vec2((float)x, (float)y), color);
+        }
     }
-
-    auto back = &tail->back();
-    render_cell(cell, back->pos.x, back->pos.y);
-    render_bridge(bridge, cell_size, back->pos, (back - 1)->pos - back->pos);
 }
 
 #endif
@@ -0,0 +1,239 @@
+#include "snake_env.h"
+
+#include "typedefs.h"
+#include "board.h"
+#include "game.h"
+#include "platform.h"
+#include "rng.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+struct SnakeEnv {
+    SnakeEnvHeader *header;
+    GameState *games;
+    i32 *actions;
+    i32 *heads;
+    i32 *food;
+    float *rewards;
+    u8 *dones;
+    char *shm_name;
+};
+
+#define ENV_ALIGNMENT 64
+// Busy-wait iterations before the lockstep loops start yielding, so the other side still gets
+// to run when both share a core.
+#define ENV_SPIN_LIMIT 4096
+
+static u64 align_offset(u64 offset) {
+    return (offset + ENV_ALIGNMENT - 1) & ~(u64)(ENV_ALIGNMENT - 1);
+}
+
+// Sizes make_board would clamp are refused, as the header has to describe the games' real boards.
+static bool32 layout_env(SnakeEnvHeader *header, i32 count, i32 width, i32 height, i32 food_count) {
+    if (count < 1 || food_count < 1 || food_count > MAX_FOOD) return false;
+    if (width < BOARD_MIN_WIDTH || height < BOARD_MIN_HEIGHT || width > BOARD_MAX_SIDE || height > BOARD_MAX_SIDE) {
+        return false;
+    }
+
+    u64 cell_count = (u64)width * (u64)height;
+    u32 words = map_word_count((u32)cell_count);
+    u64 offset = align_offset(sizeof(SnakeEnvHeader));
+
+    header->magic = SNAKE_ENV_MAGIC;
+    header->version = SNAKE_ENV_VERSION;
+    header->count = count;
+    header->width = width;
+    header->height = height;
+    header->food_count = food_count;
+    header->occupancy_words = words;
+
+    header->actions_offset = offset;
+    offset = align_offset(offset + (u64)count * sizeof(i32));
+    header->occupancy_offset = offset;
+    offset = align_offset(offset + (u64)count * words * sizeof(u64));
+    header->heads_offset = offset;
+    offset = align_offset(offset + (u64)count * 2 * sizeof(i32));
+    header->food_offset = offset;
+    offset = align_offset(offset + (u64)count * food_count * 2 * sizeof(i32));
+    header->rewards_offset = offset;
+    offset = align_offset(offset + (u64)count * sizeof(float));
+    header->dones_offset = offset;
+    offset = align_offset(offset + (u64)count);
+    header->size = offset;
+    return true;
+}
+
+static void write_observation(SnakeEnv *env, i32 index) {
+    GameState *game = &env->games[index];
+    glm::ivec2 head = tail_front(&game->snake.tail)->pos;
+    env->heads[index * 2 + 0] = head.x;
+    env->heads[index * 2 + 1] = head.y;
+
+    i32 food_count = env->header->food_count;
+    i32 *food = env->food + index * food_count * 2;
+    for (i32 i = 0; i < food_count; i++) {
+        bool32 present = i < game->food_count;
+        food[i * 2 + 0] = present ? game->food_pos[i].x : -1;
+        food[i * 2 + 1] = present ? game->food_pos[i].y : -1;
+    }
+}
+
+extern "C" uint64_t snake_env_buffer_size(int32_t count, int32_t width, int32_t height, int32_t food_count) {
+    SnakeEnvHeader header = {};
+    return layout_env(&header, count, width, height, food_count) ? header.size : 0;
+}
+
+extern "C" SnakeEnv *snake_env_create(int32_t count, int32_t width, int32_t height, int32_t food_count, uint64_t seed,
+                                      void *buffer, uint64_t buffer_size) {
+    SnakeEnvHeader layout = {};
+    if (!buffer || ((uintptr_t)buffer & (ENV_ALIGNMENT - 1))) return NULL;
+    if (!layout_env(&layout, count, width, height, food_count) || buffer_size < layout.size) return NULL;
+
+    u8 *base = (u8 *)buffer;
+    memset(base, 0, layout.size);
+    SnakeEnvHeader *header = (SnakeEnvHeader *)base;
+    *header = layout;
+
+    SnakeEnv *env = (SnakeEnv *)calloc(1, sizeof(SnakeEnv));
+    env->header = header;
+    env->games = (GameState *)calloc(count, sizeof(GameState));
+    env->actions = (i32 *)(base + header->actions_offset);
+    env->heads = (i32 *)(base + header->heads_offset);
+    env->food = (i32 *)(base + header->food_offset);
+    env->rewards = (float *)(base + header->rewards_offset);
+    env->dones = base + header->dones_offset;
+
+    // Point each game's occupancy grid into the buffer so the trainer reads it in place.
+    u64 *occupancy = (u64 *)(base + header->occupancy_offset);
+    for (i32 i = 0; i < count; i++) {
+        GameState *game = &env->games[i];
+        init_game(game, width, height);
+        free(game->map.words);
+        game->map.words = occupancy + (u64)i * header->occupancy_words;
+
+        set_food_count(game, food_count);
+        game->rng = rng_split(seed, (u64)i);
+        restart_game(game);
+        write_observation(env, i);
+    }
+
+    return env;
+}
+
+extern "C" SnakeEnv *snake_env_create_shm(const char *name, int32_t count, int32_t width, int32_t height,
+                                          int32_t food_count, uint64_t seed) {
+    u64 size = snake_env_buffer_size(count, width, height, food_count);
+    if (!size) return NULL;
+
+    u8 *buffer = platform_create_shared(name, size);
+    if (!buffer) return NULL;
+
+    SnakeEnv *env = snake_env_create(count, width, height, food_count, seed, buffer, size);
+    if (!env) {
+        platform_close_shared(buffer, size, name);
+        return NULL;
+    }
+
+    env->shm_name = (char *)malloc(strlen(name) + 1);
+    strcpy(env->shm_name, name);
+    return env;
+}
+
+extern "C" void snake_env_destroy(SnakeEnv *env) {
+    if (!env) return;
+
+    for (i32 i = 0; i < env->header->count; i++) {
+        env->games[i].map.words = NULL;
+        free_game(&env->games[i]);
+    }
+    free(env->games);
+
+    if (env->shm_name) {
+        platform_close_shared((u8 *)env->header, env->header->size, env->shm_name);
+        free(env->shm_name);
+    }
+    free(env);
+}
+
+extern "C" SnakeEnvHeader *snake_env_header(SnakeEnv *env) {
+    return env->header;
+}
+
+extern "C" void snake_env_reset(SnakeEnv *env) {
+    for (i32 i = 0; i < env->header->count; i++) {
+        restart_game(&env->games[i]);
+        write_observation(env, i);
+        env->rewards[i] = 0.0f;
+        env->dones[i] = 0;
+    }
+}
+
+extern "C" void snake_env_step(SnakeEnv *env) {
+    i32 count = env->header->count;
+
+    for (i32 i = 0; i < count; i++) {
+        GameState *game = &env->games[i];
+        i32 action = env->actions[i];
+        game->turns_queue.size = 0;
+        if (action >= DIRECTION_UP && action <= DIRECTION_LEFT) push_queue(&game->turns_queue, action);
+
+        float reward = 0.0f;
+        u8 done = 0;
+        switch (update_snake(game)) {
+            case TICK_MOVED: break;
+            case TICK_ATE: reward = 1.0f; break;
+            case TICK_DIED: reward = -1.0f; done = 1; break;
+            case TICK_WON: reward = 1.0f; done = 1; restart_game(game); break;
+        }
+
+        env->rewards[i] = reward;
+        env->dones[i] = done;
+        write_observation(env, i);
+    }
+
+    env->header->step_count++;
+}
+
+extern "C" void snake_env_serve(SnakeEnv *env) {
+    SnakeEnvHeader *header = env->header;
+    u32 spins = 0;
+
+    while (!__atomic_load_n(&header->quit, __ATOMIC_ACQUIRE)) {
+        u64 completed = header->completed_steps;
+        if (__atomic_load_n(&header->requested_steps, __ATOMIC_ACQUIRE) == completed) {
+            if (++spins > ENV_SPIN_LIMIT) std::this_thread::yield();
+            continue;
+        }
+
+        spins = 0;
+        snake_env_step(env);
+        __atomic_store_n(&header->completed_steps, completed + 1, __ATOMIC_RELEASE);
+    }
+}
+
+extern "C" SnakeEnvHeader *snake_env_attach(const char *name) {
+    u64 size = 0;
+    u8 *data = platform_open_shared(name, &size);
+    if (!data) return NULL;
+
+    SnakeEnvHeader *header = (SnakeEnvHeader *)data;
+    if (size < sizeof(SnakeEnvHeader) || header->magic != SNAKE_ENV_MAGIC || header->version != SNAKE_ENV_VERSION ||
+        size < header->size) {
+        platform_close_shared(data, size, NULL);
+        return NULL;
+    }
+    return header;
+}
+
+extern "C" void snake_env_detach(SnakeEnvHeader *header) {
+    platform_close_shared((u8 *)header, header->size, NULL);
+}
+
+extern "C" void snake_env_remote_step(SnakeEnvHeader *header) {
+    u64 target = __atomic_add_fetch(&header->requested_steps, 1, __ATOMIC_ACQ_REL);
+    for (u32 spins = 0; __atomic_load_n(&header->completed_steps, __ATOMIC_ACQUIRE) < target; spins++) {
+        if (spins > ENV_SPIN_LIMIT) std::this_thread::yield();
+    }
+}
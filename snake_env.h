@@ -0,0 +1,105 @@
+#ifndef _SNAKE_ENV_H_
+#define _SNAKE_ENV_H_
+
+// C interface to N snake games stepped together, for reinforcement-learning trainers.
+// Build with `make snake-env` (libsnakeenv.so) and load it from C, ctypes or cffi.
+//
+// Everything the trainer reads or writes lives in one contiguous buffer, either owned by the
+// caller or a POSIX shared-memory segment. The buffer starts with a SnakeEnvHeader whose
+// offsets locate the arrays below. They are all 64-byte aligned.
+//
+//   actions    int32[count]                   Direction per game: 0 none, 1 up, 2 right, 3 down, 4 left
+//   occupancy  uint64[count][occupancy_words] the games' own occupancy bitboards, bit i = cell
+//                                             y * width + x, bits past the last cell are set
+//   heads      int32[count][2]                head x, y
+//   food       int32[count][food_count][2]    food x, y, or -1, -1 for an empty slot
+//   rewards    float[count]                   +1 food or win, -1 death, 0 otherwise
+//   dones      uint8[count]                   1 when the game ended this step and was restarted
+//
+// The occupancy bitboards are the ones the games update in place, so a step copies nothing but
+// heads, food, rewards and dones. Finished games restart on the same step, as restart_game does
+// after a collision, and the observation already shows the new game.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The library is built with hidden visibility, so these are the only symbols it exports.
+#if defined(__GNUC__)
+    #define SNAKE_ENV_API __attribute__((visibility("default")))
+#else
+    #define SNAKE_ENV_API
+#endif
+
+#define SNAKE_ENV_MAGIC 0x564e454bu
+#define SNAKE_ENV_VERSION 1
+
+typedef struct SnakeEnvHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t count;
+    int32_t width;
+    int32_t height;
+    int32_t food_count;
+    uint32_t occupancy_words;
+    uint32_t reserved;
+    uint64_t size;
+    uint64_t actions_offset;
+    uint64_t occupancy_offset;
+    uint64_t heads_offset;
+    uint64_t food_offset;
+    uint64_t rewards_offset;
+    uint64_t dones_offset;
+    uint64_t step_count;
+
+    // Lockstep between a trainer and an env in another process; see snake_env_serve.
+    uint64_t requested_steps;
+    uint64_t completed_steps;
+    uint32_t quit;
+} SnakeEnvHeader;
+
+typedef struct SnakeEnv SnakeEnv;
+
+// Bytes of buffer needed for `count` games, or 0 on bad arguments, including a width outside
+// 4..16384 or a height outside 2..16384.
+SNAKE_ENV_API uint64_t snake_env_buffer_size(int32_t count, int32_t width, int32_t height, int32_t food_count);
+
+// Sets up `count` games inside `buffer`, which must hold snake_env_buffer_size() bytes, be
+// 64-byte aligned and outlive the env. Game i is seeded with rng_split(seed, i). Returns
+// NULL on bad arguments.
+SNAKE_ENV_API SnakeEnv *snake_env_create(int32_t count, int32_t width, int32_t height, int32_t food_count,
+                                         uint64_t seed, void *buffer, uint64_t buffer_size);
+
+// Same, inside a new POSIX shared-memory segment `name` (e.g. "/snake-env") that other
+// processes can map with snake_env_attach.
+SNAKE_ENV_API SnakeEnv *snake_env_create_shm(const char *name, int32_t count, int32_t width, int32_t height,
+                                             int32_t food_count, uint64_t seed);
+
+SNAKE_ENV_API void snake_env_destroy(SnakeEnv *env);
+
+SNAKE_ENV_API SnakeEnvHeader *snake_env_header(SnakeEnv *env);
+
+// Restarts every game and rewrites the observations.
+SNAKE_ENV_API void snake_env_reset(SnakeEnv *env);
+
+// Applies `actions`, advances every game by one tick and writes observations, rewards and dones.
+SNAKE_ENV_API void snake_env_step(SnakeEnv *env);
+
+// Runs steps on request until the header's quit flag is set: each bump of requested_steps
+// gets one snake_env_step, then completed_steps catches up. Spins, then yields, while waiting.
+SNAKE_ENV_API void snake_env_serve(SnakeEnv *env);
+
+// Trainer side of snake_env_serve: maps an existing segment read-write and returns its header.
+SNAKE_ENV_API SnakeEnvHeader *snake_env_attach(const char *name);
+SNAKE_ENV_API void snake_env_detach(SnakeEnvHeader *header);
+
+// Requests one step from the serving process and waits for it.
+SNAKE_ENV_API void snake_env_remote_step(SnakeEnvHeader *header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,266 @@
+#include "typedefs.h"
+#include "board.h"
+#include "game.h"
+#include "replay.h"
+#include "autopilot.h"
+#include "hamiltonian.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum SimAgent {
+    AGENT_GREEDY,
+    AGENT_AUTOPILOT,
+    AGENT_SOLVER,
+};
+
+struct SimConfig {
+    i32 board_width;
+    i32 board_height;
+    i32 game_count;
+    i32 thread_count;
+    i64 max_ticks;
+    i32 food_count;
+    u64 seed;
+    i32 agent;
+    const char *record_path;
+    const char *replay_path;
+    i64 replay_tick;
+};
+
+struct SimTotals {
+    std::atomic<i64> ticks;
+    std::atomic<i64> games;
+    std::atomic<i64> wins;
+    std::atomic<i64> food_eaten;
+};
+
+// Greedy agent: step towards the food through any cell that isn't occupied right now.
+static i32 choose_direction(GameState *game) {
+    glm::ivec2 head = tail_front(&game->snake.tail)->pos;
+    i32 best_direction = DIRECTION_NONE;
+    i32 best_distance = INT32_MAX;
+
+    for (i32 direction = DIRECTION_UP; direction <= DIRECTION_LEFT; direction++) {
+        glm::ivec2 velocity = direction_to_velocity(direction);
+        if (velocity + game->snake.velocity == glm::ivec2(0, 0)) continue;
+
+        glm::ivec2 next = board_wrap(&game->board, head + velocity);
+        if (map_at(&game->map, board_index(&game->board, next))) continue;
+
+        i32 distance = INT32_MAX;
+        for (i32 i = 0; i < game->food_count; i++) {
+            i32 food_distance = board_distance(&game->board, next, game->food_pos[i]);
+            if (food_distance < distance) distance = food_distance;
+        }
+
+        if (distance < best_distance) {
+            best_distance = distance;
+            best_direction = direction;
+        }
+    }
+
+    return best_direction;
+}
+
+static void run_games(SimConfig *config, std::atomic<i32> *next_game, SimTotals *totals) {
+    GameState *game = new GameState();
+    init_game(game, config->board_width, config->board_height);
+    set_food_count(game, config->food_count);
+    Autopilot pilot = {};
+    if (config->agent == AGENT_AUTOPILOT) init_autopilot(&pilot, &game->board);
+    const HamiltonianCycle *cycle = config->agent == AGENT_SOLVER ? cycle_for_board(&game->board) : NULL;
+    i64 ticks = 0, games = 0, wins = 0, food_eaten = 0;
+
+    i32 game_index;
+    while ((game_index = next_game->fetch_add(1, std::memory_order_relaxed)) < config->game_count) {
+        game->rng = rng_split(config->seed, (u64)game_index);
+        restart_game(game);
+        if (config->agent == AGENT_AUTOPILOT) reset_autopilot(&pilot, game);
+
+        ReplayRecorder recorder = {};
+        bool32 is_recording = config->record_path && game_index == 0;
+        if (is_recording) begin_recording(&recorder, game, config->seed, REPLAY_DEFAULT_KEYFRAME_INTERVAL);
+
+        for (i64 tick = 0; tick < config->max_ticks; tick++) {
+            i32 direction;
+            if (config->agent == AGENT_AUTOPILOT) {
+                direction = autopilot_steer(&pilot, game);
+            } else if (config->agent == AGENT_SOLVER) {
+                direction = hamiltonian_steer(cycle, game);
+            } else {
+                direction = choose_direction(game);
+                if (direction) push_queue(&game->turns_queue, direction);
+            }
+            if (direction && is_recording) record_event(&recorder, direction);
+
+            TickResult result = update_snake(game);
+            if (config->agent == AGENT_AUTOPILOT) autopilot_tick(&pilot, game, result);
+            if (is_recording) record_tick(&recorder, game);
+            ticks++;
+
+            if (result == TICK_ATE) food_eaten++;
+            if (result == TICK_DIED) break;
+            if (result == TICK_WON) {
+                wins++;
+                break;
+            }
+        }
+
+        if (is_recording) {
+            if (!save_replay(&recorder, config->record_path)) {
+                fprintf(stderr, "can't write replay %s\n", config->record_path);
+            }
+            free_recorder(&recorder);
+        }
+        games++;
+    }
+
+    totals->ticks += ticks;
+    totals->games += games;
+    totals->wins += wins;
+    totals->food_eaten += food_eaten;
+    if (config->agent == AGENT_AUTOPILOT) free_autopilot(&pilot);
+    free_game(game);
+    delete game;
+}
+
+static void print_replay_state(const char *label, GameState *game, u64 tick) {
+    printf("%-12s tick %llu, length %u, %d cells left\n", label, (unsigned long long)tick,
+           game->snake.tail.size, game->cells_left);
+}
+
+// Plays a recorded game back headless: once from the start to measure fast-forward
+// throughput, then (with -k) a keyframe seek to the requested tick.
+static i32 run_replay(SimConfig *config) {
+    Replay replay = {};
+    if (!open_replay(&replay, config->replay_path)) {
+        fprintf(stderr, "can't open replay %s\n", config->replay_path);
+        return 1;
+    }
+
+    ReplayHeader *header = &replay.header;
+    GameState *game = new GameState();
+    init_game(game, header->width, header->height);
+
+    ReplayCursor cursor = {};
+    bool32 valid = seek_replay(&replay, game, &cursor, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    while (valid && step_replay(&replay, game, &cursor, NULL)) {}
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (valid) {
+        printf("board:       %dx%d\n", header->width, header->height);
+        printf("seed:        %llu\n", (unsigned long long)header->seed);
+        printf("size:        %llu bytes (%llu events, %llu keyframes)\n", (unsigned long long)replay.size,
+               (unsigned long long)header->event_count, (unsigned long long)header->keyframe_count);
+        printf("elapsed:     %.3f s\n", seconds);
+        printf("ticks/sec:   %.0f\n", cursor.tick / seconds);
+        print_replay_state("end:", game, cursor.tick);
+    }
+
+    if (valid && config->replay_tick >= 0) {
+        start = std::chrono::steady_clock::now();
+        valid = seek_replay(&replay, game, &cursor, (u64)config->replay_tick);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (valid) {
+            print_replay_state("seek:", game, cursor.tick);
+            printf("seek time:   %.3f ms\n", seconds * 1000.0);
+        }
+    }
+
+    if (!valid) fprintf(stderr, "replay %s is corrupt\n", config->replay_path);
+
+    free_game(game);
+    delete game;
+    close_replay(&replay);
+    return valid ? 0 : 1;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [-b WIDTHxHEIGHT] [-n games] [-j threads] [-t max_ticks_per_game] [-f food_count] [-s seed] [-a | -c]\n"
+            "       [-r record_game_0.replay] [-p play.replay [-k seek_tick]]\n",
+            program);
+}
+
+i32 main(i32 argc, char **argv) {
+    SimConfig config = {};
+    config.board_width = 15;
+    config.board_height = 15;
+    config.game_count = 10000;
+    config.thread_count = (i32)std::thread::hardware_concurrency();
+    config.max_ticks = 100000;
+    config.food_count = 1;
+    config.seed = (u64)time(0);
+    config.replay_tick = -1;
+
+    for (i32 i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-b") && i + 1 < argc &&
+            parse_board_size(argv[i + 1], &config.board_width, &config.board_height)) {
+            i++;
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            config.game_count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            config.thread_count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            config.max_ticks = atoll(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            config.food_count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-a")) {
+            config.agent = AGENT_AUTOPILOT;
+        } else if (!strcmp(argv[i], "-c")) {
+            config.agent = AGENT_SOLVER;
+        } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            config.record_path = argv[++i];
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            config.replay_path = argv[++i];
+        } else if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+            config.replay_tick = atoll(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.replay_path) return run_replay(&config);
+    if (config.thread_count < 1) config.thread_count = 1;
+
+    SimTotals totals = {};
+    std::atomic<i32> next_game(0);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < config.thread_count; i++) {
+        threads.emplace_back(run_games, &config, &next_game, &totals);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    i64 ticks = totals.ticks, games = totals.games;
+    printf("board:       %dx%d\n", config.board_width, config.board_height);
+    printf("seed:        %llu\n", (unsigned long long)config.seed);
+    printf("threads:     %d\n", config.thread_count);
+    printf("games:       %lld (%lld won)\n", (long long)games, (long long)totals.wins.load());
+    printf("ticks:       %lld\n", (long long)ticks);
+    printf("food eaten:  %lld (%.2f per game)\n", (long long)totals.food_eaten.load(), games ? (double)totals.food_eaten / games : 0.0);
+    printf("elapsed:     %.3f s\n", seconds);
+    printf("ticks/sec:   %.0f\n", ticks / seconds);
+    printf("games/sec:   %.1f\n", games / seconds);
+
+    return 0;
+}
@@ -0,0 +1,345 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include "typedefs.h"
+#include "platform.h"
+#include "byte_buffer.h"
+#include "game.h"
+
+#include <glm/glm.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// In-memory snapshots: a flat, pointer-free copy of a GameState written into a caller-provided
+// buffer, so search and rollback can clone states without touching the heap. The fixed-size
+// GameSnapshot is followed in the same buffer by
+//
+//   map     u64[word_count]   occupancy words
+//   body    TailPiece[tail_size], head first
+//   slot    u32[cell_count]   free-cell slot of every cell
+//   cells   u32[free_count]   the live free cells of each spawn region, back to back
+//
+// A snapshot can only be restored into a game made by init_game with the same board size
+// and spawn regions.
+struct GameSnapshot {
+    u64 size;
+    i32 width;
+    i32 height;
+    i32 region_count;
+    u32 tail_size;
+    u32 free_count;
+    glm::ivec2 velocity;
+    bool32 should_grow;
+    bool32 paused;
+    bool32 is_over;
+    i32 cells_left;
+    i32 food_target;
+    i32 food_count;
+    TurnsQueue turns_queue;
+    Rng rng;
+    u32 region_free[MAX_SPAWN_REGIONS];
+    glm::ivec2 food_pos[MAX_FOOD];
+};
+
+#define SNAPSHOT_HEADER_SIZE ((sizeof(GameSnapshot) + 7) & ~(size_t)7)
+
+// Largest snapshot the game can produce; the body and free cells never exceed cell_count together.
+// 64-bit, as a BOARD_MAX_SIDE square board needs more than 4 GiB.
+u64 snapshot_capacity(GameState *game) {
+    return SNAPSHOT_HEADER_SIZE + (u64)game->map.word_count * sizeof(u64) +
+           (u64)game->board.cell_count * (sizeof(u32) + sizeof(TailPiece) + sizeof(u32));
+}
+
+// Returns the number of bytes written, at most snapshot_capacity(game).
+u64 save_snapshot(GameState *game, void *buffer) {
+    GameSnapshot *snapshot = (GameSnapshot *)buffer;
+    FreeCellSet *free_cells = &game->free_cells;
+    TailRing *tail = &game->snake.tail;
+
+    snapshot->width = game->board.width;
+    snapshot->height = game->board.height;
+    snapshot->region_count = free_cells->region_count;
+    snapshot->tail_size = tail->size;
+    snapshot->free_count = free_cells_total(free_cells);
+    snapshot->velocity = game->snake.velocity;
+    snapshot->should_grow = game->snake.should_grow;
+    snapshot->paused = game->paused;
+    snapshot->is_over = game->is_over;
+    snapshot->cells_left = game->cells_left;
+    snapshot->food_target = game->food_target;
+    snapshot->food_count = game->food_count;
+    snapshot->turns_queue = game->turns_queue;
+    snapshot->rng = game->rng;
+    memcpy(snapshot->region_free, free_cells->region_free, sizeof(snapshot->region_free));
+    memcpy(snapshot->food_pos, game->food_pos, sizeof(snapshot->food_pos));
+
+    u8 *cursor = (u8 *)buffer + SNAPSHOT_HEADER_SIZE;
+
+    memcpy(cursor, game->map.words, game->map.word_count * sizeof(u64));
+    cursor += game->map.word_count * sizeof(u64);
+
+    TailSpans spans = tail_spans(tail);
+    memcpy(cursor, spans.first, spans.first_count * sizeof(TailPiece));
+    cursor += spans.first_count * sizeof(TailPiece);
+    memcpy(cursor, spans.second, spans.second_count * sizeof(TailPiece));
+    cursor += spans.second_count * sizeof(TailPiece);
+
+    memcpy(cursor, free_cells->slot, free_cells->cell_count * sizeof(u32));
+    cursor += free_cells->cell_count * sizeof(u32);
+
+    for (i32 region = 0; region < free_cells->region_count; region++) {
+        u32 count = free_cells->region_free[region];
+        memcpy(cursor, free_cells->cells + free_cells->region_start[region], count * sizeof(u32));
+        cursor += count * sizeof(u32);
+    }
+
+    snapshot->size = (u64)(cursor - (u8 *)buffer);
+    return snapshot->size;
+}
+
+// Returns false, leaving the game untouched, if the snapshot was taken on a different board.
+bool32 restore_snapshot(GameState *game, const void *buffer) {
+    const GameSnapshot *snapshot = (const GameSnapshot *)buffer;
+    FreeCellSet *free_cells = &game->free_cells;
+    TailRing *tail = &game->snake.tail;
+
+    if (snapshot->width != game->board.width || snapshot->height != game->board.height ||
+        snapshot->region_count != free_cells->region_count) {
+        return false;
+    }
+
+    game->snake.velocity = snapshot->velocity;
+    game->snake.should_grow = snapshot->should_grow;
+    game->paused = snapshot->paused;
+    game->is_over = snapshot->is_over;
+    game->cells_left = snapshot->cells_left;
+    game->food_target = snapshot->food_target;
+    game->food_count = snapshot->food_count;
+    game->turns_queue = snapshot->turns_queue;
+    game->rng = snapshot->rng;
+    memcpy(free_cells->region_free, snapshot->region_free, sizeof(free_cells->region_free));
+    memcpy(game->food_pos, snapshot->food_pos, sizeof(game->food_pos));
+
+    const u8 *cursor = (const u8 *)buffer + SNAPSHOT_HEADER_SIZE;
+
+    memcpy(game->map.words, cursor, game->map.word_count * sizeof(u64));
+    cursor += game->map.word_count * sizeof(u64);
+
+    tail_clear(tail);
+    tail->size = snapshot->tail_size;
+    memcpy(tail->data, cursor, snapshot->tail_size * sizeof(TailPiece));
+    cursor += snapshot->tail_size * sizeof(TailPiece);
+
+    memcpy(free_cells->slot, cursor, free_cells->cell_count * sizeof(u32));
+    cursor += free_cells->cell_count * sizeof(u32);
+
+    for (i32 region = 0; region < free_cells->region_count; region++) {
+        u32 count = free_cells->region_free[region];
+        memcpy(free_cells->cells + free_cells->region_start[region], cursor, count * sizeof(u32));
+        cursor += count * sizeof(u32);
+    }
+
+    return true;
+}
+
+// Portable form for replay keyframes and save files: everything update_snake reads except
+// food_target, including the free-cell order since food sampling depends on it. The body is
+// the head cell followed by 2-bit steps towards the tail.
+static void encode_game_state(ByteBuffer *buffer, GameState *game) {
+    write_u8(buffer, (u8)((game->snake.should_grow ? 1 : 0) | (game->paused ? 2 : 0) | (game->is_over ? 4 : 0)));
+    write_u8(buffer, (u8)velocity_to_direction(game->snake.velocity));
+    write_varint(buffer, (u32)game->cells_left);
+
+    write_varint(buffer, (u64)game->food_count);
+    for (i32 i = 0; i < game->food_count; i++) {
+        write_varint(buffer, board_index(&game->board, game->food_pos[i]));
+    }
+
+    write_varint(buffer, (u64)game->turns_queue.size);
+    for (i32 i = 0; i < game->turns_queue.size; i++) {
+        write_u8(buffer, (u8)game->turns_queue.data[i]);
+    }
+
+    for (i32 i = 0; i < 4; i++) {
+        write_u64(buffer, game->rng.s[i]);
+    }
+
+    TailRing *tail = &game->snake.tail;
+    write_varint(buffer, tail->size);
+    write_varint(buffer, board_index(&game->board, tail_front(tail)->pos));
+
+    u8 packed = 0;
+    for (u32 i = 1; i < tail->size; i++) {
+        glm::ivec2 step = board_wrap_delta(&game->board, tail_at(tail, i)->pos - tail_at(tail, i - 1)->pos);
+        packed |= (u8)(velocity_to_direction(step) - DIRECTION_UP) << (2 * ((i - 1) & 3));
+        if (((i - 1) & 3) == 3 || i == tail->size - 1) {
+            write_u8(buffer, packed);
+            packed = 0;
+        }
+    }
+
+    FreeCellSet *free_cells = &game->free_cells;
+    write_varint(buffer, (u64)free_cells->region_count);
+    for (i32 region = 0; region < free_cells->region_count; region++) {
+        u32 start = free_cells->region_start[region];
+        write_varint(buffer, free_cells->region_free[region]);
+        for (u32 i = 0; i < free_cells->region_free[region]; i++) {
+            write_varint(buffer, free_cells->cells[start + i]);
+        }
+    }
+}
+
+// `game` must come from init_game with the same board size and spawn regions. Counts are
+// checked before they index anything, and the food and free cells are checked against the
+// decoded body, so a corrupt or crafted state is rejected rather than restored inconsistent.
+static bool32 decode_game_state(ByteReader *reader, GameState *game) {
+    const Board *board = &game->board;
+
+    u8 flags = read_u8(reader);
+    game->snake.should_grow = (flags & 1) != 0;
+    game->paused = (flags & 2) != 0;
+    game->is_over = (flags & 4) != 0;
+    game->snake.velocity = direction_to_velocity(read_u8(reader));
+    u64 cells_left = read_varint(reader);
+
+    u64 food_count = read_varint(reader);
+    if (food_count > MAX_FOOD) return false;
+    game->food_count = (i32)food_count;
+    for (u32 i = 0; i < (u32)food_count; i++) {
+        game->food_pos[i] = board_position(board, (u32)read_varint(reader) % board->cell_count);
+    }
+
+    u64 queue_size = read_varint(reader);
+    if (queue_size > ARR_SIZE(game->turns_queue.data)) return false;
+    game->turns_queue.size = (i32)queue_size;
+    for (u32 i = 0; i < (u32)queue_size; i++) {
+        game->turns_queue.data[i] = read_u8(reader);
+    }
+
+    for (i32 i = 0; i < 4; i++) {
+        game->rng.s[i] = read_u64(reader);
+    }
+
+    TailRing *tail = &game->snake.tail;
+    u64 length = read_varint(reader);
+    if (length == 0 || length > board->cell_count) return false;
+
+    // Every growth takes one cell off cells_left, so it always equals the cells the body doesn't cover.
+    if (cells_left != board->cell_count - length) return false;
+    game->cells_left = (i32)cells_left;
+
+    tail_clear(tail);
+    map_clear(&game->map);
+
+    glm::ivec2 pos = board_position(board, (u32)read_varint(reader) % board->cell_count);
+    tail_push_back(tail, { pos });
+    map_set(&game->map, board_index(board, pos), 1);
+
+    u8 packed = 0;
+    for (u32 i = 1; i < (u32)length; i++) {
+        if (((i - 1) & 3) == 0) packed = read_u8(reader);
+        i32 direction = DIRECTION_UP + ((packed >> (2 * ((i - 1) & 3))) & 3);
+        pos = board_wrap(board, pos + direction_to_velocity(direction));
+
+        u32 cell = board_index(board, pos);
+        if (map_at(&game->map, cell)) return false;
+        tail_push_back(tail, { pos });
+        map_set(&game->map, cell, 1);
+    }
+
+    // Food sits on distinct cells off the body, except under the head of a won game, which stops
+    // before eating it.
+    u64 food_off_body = 0;
+    for (u32 i = 0; i < (u32)food_count; i++) {
+        if (food_at(game, game->food_pos[i]) != (i32)i) return false;
+        if (!map_at(&game->map, board_index(board, game->food_pos[i]))) {
+            food_off_body++;
+        } else if (!game->is_over || game->food_pos[i] != tail_front(tail)->pos) {
+            return false;
+        }
+    }
+
+    // The free cells keep their saved order, which sampling depends on, but each has to be a
+    // cell of its region that is neither body nor food and listed once. With the total matching,
+    // that makes them exactly the cells the map and food leave free.
+    FreeCellSet *free_cells = &game->free_cells;
+    if (read_varint(reader) != (u64)free_cells->region_count) return false;
+
+    memset(free_cells->slot, 0xff, free_cells->cell_count * sizeof(u32));
+    u64 free_total = 0;
+    for (i32 region = 0; region < free_cells->region_count; region++) {
+        u32 start = free_cells->region_start[region];
+        u64 count = read_varint(reader);
+        if (count > free_cells->region_size[region]) return false;
+
+        free_cells->region_free[region] = (u32)count;
+        free_total += count;
+        for (u32 i = 0; i < (u32)count; i++) {
+            u64 cell = read_varint(reader);
+            if (cell >= board->cell_count || free_cells->region_of[cell] != region ||
+                free_cells->slot[cell] != INVALID_SLOT || map_at(&game->map, (u32)cell) ||
+                food_at(game, board_position(board, (u32)cell)) >= 0) {
+                return false;
+            }
+            free_cells->cells[start + i] = (u32)cell;
+            free_cells->slot[cell] = start + i;
+        }
+    }
+
+    if (free_total != board->cell_count - length - food_off_body) return false;
+    return reader->ok;
+}
+
+// Save files: "SNKS", u32 version, u32 width, u32 height, u32 food_target, then the state as
+// encode_game_state() writes it. Bump the version whenever that encoding changes.
+#define SNAPSHOT_FILE_MAGIC "SNKS"
+#define SNAPSHOT_FILE_VERSION 1
+
+bool32 save_game_file(GameState *game, const char *path) {
+    ByteBuffer buffer = {};
+    write_bytes(&buffer, SNAPSHOT_FILE_MAGIC, 4);
+    write_u32(&buffer, SNAPSHOT_FILE_VERSION);
+    write_u32(&buffer, (u32)game->board.width);
+    write_u32(&buffer, (u32)game->board.height);
+    write_u32(&buffer, (u32)game->food_target);
+    encode_game_state(&buffer, game);
+
+    FILE *file = fopen(path, "wb");
+    bool32 success = file != NULL;
+    if (file) {
+        success = fwrite(buffer.data, 1, buffer.size, file) == buffer.size;
+        success = fclose(file) == 0 && success;
+    }
+
+    free_buffer(&buffer);
+    return success;
+}
+
+// `game` must come from init_game with the saved board size. On failure the game may be
+// left half-restored; restart_game recovers it.
+bool32 load_game_file(GameState *game, const char *path) {
+    u64 size;
+    const u8 *data = platform_map_file(path, &size);
+    if (!data) return false;
+
+    ByteReader reader = make_reader(data, size);
+    char magic[4];
+    read_bytes(&reader, magic, 4);
+    u32 version = read_u32(&reader);
+    i32 width = (i32)read_u32(&reader);
+    i32 height = (i32)read_u32(&reader);
+    i32 food_target = (i32)read_u32(&reader);
+
+    bool32 success = reader.ok && !memcmp(magic, SNAPSHOT_FILE_MAGIC, 4) && version == SNAPSHOT_FILE_VERSION &&
+                     width == game->board.width && height == game->board.height;
+    if (success) {
+        set_food_count(game, food_target);
+        success = decode_game_state(&reader, game);
+    }
+
+    platform_unmap_file(data, size);
+    return success;
+}
+
+#endif
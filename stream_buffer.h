@@ -0,0 +1,186 @@
+#ifndef _STREAM_BUFFER_H_
+#define _STREAM_BUFFER_H_
+
+#include "typedefs.h"
+
+#include <glad/glad.h>
+#include <string.h>
+
+// One buffer for everything a frame writes for the GPU: instance attributes, the frame's
+// uniform block. It's split into STREAM_BUFFER_REGIONS regions used in turn, one per frame, and
+// each frame drops a fence after its last draw. Before a region is written again, its fence
+// is waited on, which is free unless the GPU is that many frames behind; such waits are
+// counted as stalls.
+//
+// With ARB_buffer_storage (core in 4.4; glad here only loads 3.3, so the entry point comes
+// through the platform loader) the buffer is mapped once, persistently and coherently, and
+// writes are plain copies. Without it, the first write of each frame orphans the buffer and
+// writes go through glBufferSubData into the fresh storage, so neither path waits on draws
+// still reading earlier frames.
+//
+// A frame reserves what it will write in begin_stream_frame, so the buffer only ever grows
+// between frames, never while something written this frame is bound.
+
+#define STREAM_BUFFER_REGIONS 3
+#define STREAM_BUFFER_INITIAL_SIZE (64 * 1024)
+#define STREAM_BUFFER_MIN_ALIGNMENT 16
+#define STREAM_BUFFER_WAIT_NS 1000000000ull
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+typedef void (APIENTRYP StreamBufferStorageProc)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+struct StreamBuffer {
+    u32 buffer;
+    u8 *mapped;
+    StreamBufferStorageProc buffer_storage;
+    u32 alignment;
+    u64 region_size;
+    u32 region;
+    u64 used;
+    GLsync fences[STREAM_BUFFER_REGIONS];
+
+    u64 frames;
+    u64 stalls;
+    u64 bytes_written;
+};
+
+static bool32 has_gl_extension(const char *name) {
+    i32 count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (i32 i = 0; i < count; i++) {
+        const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, (u32)i);
+        if (extension && !strcmp(extension, name)) return true;
+    }
+    return false;
+}
+
+static void allocate_stream_buffer(StreamBuffer *stream, u64 region_size) {
+    if (stream->buffer) {
+        // In-flight draws keep the old storage alive; its fences are of no use to the new one.
+        if (stream->mapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glDeleteBuffers(1, &stream->buffer);
+        for (i32 i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+            if (stream->fences[i]) glDeleteSync(stream->fences[i]);
+            stream->fences[i] = 0;
+        }
+    }
+
+    stream->region_size = region_size;
+    stream->mapped = NULL;
+    glGenBuffers(1, &stream->buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer);
+    if (stream->buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = (GLsizeiptr)(region_size * STREAM_BUFFER_REGIONS);
+        stream->buffer_storage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+        stream->mapped = (u8 *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+    }
+    if (!stream->mapped) {
+        stream->buffer_storage = NULL;
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)region_size, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// `load` is the platform's GL loader (glfwGetProcAddress, eglGetProcAddress). With
+// `allow_persistent` false the orphaning path is used even where mapping would work.
+void init_stream_buffer(StreamBuffer *stream, GLADloadproc load, bool32 allow_persistent) {
+    memset(stream, 0, sizeof(*stream));
+
+    i32 uniform_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+    stream->alignment = uniform_alignment > STREAM_BUFFER_MIN_ALIGNMENT ? (u32)uniform_alignment : STREAM_BUFFER_MIN_ALIGNMENT;
+
+    if (allow_persistent && (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4) ||
+                             has_gl_extension("GL_ARB_buffer_storage"))) {
+        stream->buffer_storage = (StreamBufferStorageProc)load("glBufferStorage");
+    }
+    allocate_stream_buffer(stream, STREAM_BUFFER_INITIAL_SIZE);
+}
+
+void free_stream_buffer(StreamBuffer *stream) {
+    if (stream->mapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &stream->buffer);
+    for (i32 i = 0; i < STREAM_BUFFER_REGIONS; i++) {
+        if (stream->fences[i]) glDeleteSync(stream->fences[i]);
+    }
+    memset(stream, 0, sizeof(*stream));
+}
+
+bool32 is_stream_buffer_persistent(const StreamBuffer *stream) {
+    return stream->mapped != NULL;
+}
+
+// Room `size` bytes take in a frame, alignment included.
+u64 stream_space(const StreamBuffer *stream, u64 size) {
+    return (size + stream->alignment - 1) / stream->alignment * stream->alignment;
+}
+
+// `bytes` is everything the frame will write, summed with stream_space.
+void begin_stream_frame(StreamBuffer *stream, u64 bytes) {
+    if (bytes > stream->region_size) {
+        u64 region_size = stream->region_size;
+        while (region_size < bytes) region_size *= 2;
+        allocate_stream_buffer(stream, region_size);
+    }
+
+    stream->region = (stream->region + 1) % STREAM_BUFFER_REGIONS;
+    stream->used = 0;
+    stream->frames++;
+
+    GLsync fence = stream->fences[stream->region];
+    if (fence) {
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            stream->stalls++;
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_WAIT_NS) == GL_TIMEOUT_EXPIRED) {}
+        }
+        glDeleteSync(fence);
+        stream->fences[stream->region] = 0;
+    }
+
+    if (!stream->mapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)stream->region_size, NULL, GL_STREAM_DRAW);
+    }
+}
+
+// Copies `size` bytes into this frame's region and returns their offset in `buffer`, or -1
+// when they don't fit in what begin_stream_frame reserved.
+i64 stream_write(StreamBuffer *stream, const void *data, u64 size) {
+    u64 space = stream_space(stream, size);
+    if (stream->used + space > stream->region_size) return -1;
+
+    u64 offset = stream->used;
+    stream->used += space;
+    stream->bytes_written += size;
+
+    if (stream->mapped) {
+        offset += stream->region * stream->region_size;
+        memcpy(stream->mapped + offset, data, size);
+    } else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+    }
+    return (i64)offset;
+}
+
+// After the frame's last draw reading the region.
+void end_stream_frame(StreamBuffer *stream) {
+    if (stream->mapped) {
+        stream->fences[stream->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    } else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef _TAIL_RING_H_
+#define _TAIL_RING_H_
+
+#include "typedefs.h"
+
+#include <glm/glm.hpp>
+#include <stdlib.h>
+#include <string.h>
+
+struct TailPiece {
+    glm::ivec2 pos;
+};
+
+// Fixed-capacity ring of tail pieces, front (index 0) is the head.
+// Capacity is a power of two so wrapping an index is a single mask.
+// `generation` changes whenever pieces move to other slots or the ring starts over, and is
+// never reused by rings changed on the same thread, so copies kept elsewhere (body_mirror.h)
+// can tell pushes and pops apart from a rebuild.
+struct TailRing {
+    TailPiece *data;
+    u32 mask;
+    u32 head;
+    u32 size;
+    u32 generation;
+};
+
+// The live pieces in front-to-back order, split where the ring wraps.
+struct TailSpans {
+    TailPiece *first;
+    u32 first_count;
+    TailPiece *second;
+    u32 second_count;
+};
+
+// Per thread, as search threads clear rings on every rollout.
+static thread_local u32 tail_generations;
+
+static u32 round_up_pow2(u32 value) {
+    u32 result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+void init_tail(TailRing *tail, u32 max_length) {
+    u32 capacity = round_up_pow2(max_length);
+    tail->data = (TailPiece *)malloc(capacity * sizeof(TailPiece));
+    tail->mask = capacity - 1;
+    tail->head = 0;
+    tail->size = 0;
+    tail->generation = ++tail_generations;
+}
+
+void free_tail(TailRing *tail) {
+    free(tail->data);
+    tail->data = NULL;
+    tail->mask = 0;
+    tail->head = 0;
+    tail->size = 0;
+}
+
+static void tail_clear(TailRing *tail) {
+    tail->head = 0;
+    tail->size = 0;
+    tail->generation = ++tail_generations;
+}
+
+static TailPiece *tail_at(TailRing *tail, u32 index) {
+    return &tail->data[(tail->head + index) & tail->mask];
+}
+
+static TailPiece *tail_front(TailRing *tail) {
+    return &tail->data[tail->head];
+}
+
+static TailPiece *tail_back(TailRing *tail) {
+    return tail_at(tail, tail->size - 1);
+}
+
+static void tail_push_front(TailRing *tail, TailPiece piece) {
+    tail->head = (tail->head - 1) & tail->mask;
+    tail->data[tail->head] = piece;
+    tail->size++;
+}
+
+static void tail_push_back(TailRing *tail, TailPiece piece) {
+    tail->data[(tail->head + tail->size) & tail->mask] = piece;
+    tail->size++;
+}
+
+static void tail_pop_back(TailRing *tail) {
+    tail->size--;
+}
+
+static TailSpans tail_spans(TailRing *tail) {
+    TailSpans spans;
+    u32 capacity = tail->mask + 1;
+    u32 until_wrap = capacity - tail->head;
+
+    spans.first = tail->data + tail->head;
+    spans.first_count = tail->size < until_wrap ? tail->size : until_wrap;
+    spans.second = tail->data;
+    spans.second_count = tail->size - spans.first_count;
+
+    return spans;
+}
+
+// Grows the ring so it holds at least `max_length` pieces, keeping their order.
+void tail_reserve(TailRing *tail, u32 max_length) {
+    if (max_length <= tail->mask + 1) return;
+
+    u32 capacity = round_up_pow2(max_length);
+    TailPiece *data = (TailPiece *)malloc(capacity * sizeof(TailPiece));
+    TailSpans spans = tail_spans(tail);
+    memcpy(data, spans.first, spans.first_count * sizeof(TailPiece));
+    memcpy(data + spans.first_count, spans.second, spans.second_count * sizeof(TailPiece));
+
+    free(tail->data);
+    tail->data = data;
+    tail->mask = capacity - 1;
+    tail->head = 0;
+    tail->generation = ++tail_generations;
+}
+
+#endif